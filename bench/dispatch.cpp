@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+#include <machine.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// The state dispatch alone: fill_data() and parse() until it returns false, over valid sentences in chunks of 10 to 100
+// bytes. It uses nothing the machine did not have back when its states were virtual, so the same file builds against
+// that tree for the baseline.
+
+namespace
+{
+    struct dispatch_counter
+    {
+        static inline size_t fixes = 0;
+        static void callback(serial::minmea_sentence_rmc const &)
+        {
+            ++fixes;
+        }
+    };
+
+    std::string const & dispatch_stream()
+    {
+        static std::string const s = []
+        {
+            std::string s;
+            for (int i = 0; i < 1000; ++i)
+            {
+                s += "$GPRMC,081836.000,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*75\x0D\x0A"
+                     "$GPRMC,225446,A,4916.45,N,12311.12,W,000.5,054.7,191119,020.3,E*6D\x0D\x0A";
+            }
+            return s;
+        }();
+        return s;
+    }
+
+    std::vector<size_t> const & dispatch_chunks()
+    {
+        static std::vector<size_t> const sizes = []
+        {
+            std::mt19937 gen(7);
+            std::uniform_int_distribution<size_t> dis(10, 100);
+            std::vector<size_t> v;
+            for (size_t total = 0; total < dispatch_stream().size(); total += v.back())
+            {
+                v.push_back(std::min(dis(gen), dispatch_stream().size() - total));
+            }
+            return v;
+        }();
+        return sizes;
+    }
+
+    void BM_state_dispatch(benchmark::State & state)
+    {
+        auto const & input = dispatch_stream();
+        serial::machine<300, dispatch_counter> m;
+        auto const fixes = dispatch_counter::fixes;
+        for (auto _ : state)
+        {
+            auto data = input.data();
+            for (auto const chunk : dispatch_chunks())
+            {
+                m.fill_data(data, chunk);
+                data += chunk;
+                while (m.parse());
+            }
+        }
+        state.SetBytesProcessed(int64_t(state.iterations()) * input.size());
+        state.counters["sentences/s"] = benchmark::Counter(double(dispatch_counter::fixes - fixes), benchmark::Counter::kIsRate);
+    }
+    BENCHMARK(BM_state_dispatch);
+}
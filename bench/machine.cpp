@@ -0,0 +1,144 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <push.h>
+#include "streams.h"
+
+
+// End-to-end throughput of the machine over recorded-like streams delivered in random chunks, in MB/s and sentences/s,
+// for the ring sizes from the smallest that holds a sentence on. Ranges are clean (0) or noisy (1) input.
+
+namespace
+{
+    std::string const & stream(benchmark::State const & state)
+    {
+        return state.range(0) ? bench::noisy_stream() : bench::clean_stream();
+    }
+
+    void count(benchmark::State & state, std::string const & input, size_t fixes)
+    {
+        state.SetBytesProcessed(int64_t(state.iterations()) * input.size());
+        state.counters["sentences/s"] = benchmark::Counter(double(fixes), benchmark::Counter::kIsRate);
+    }
+
+    // fill_data() and the states over the ring
+    template <size_t bs>
+    void BM_machine_parse_loop(benchmark::State & state)
+    {
+        auto const & input = stream(state);
+        bench::staged_machine<bs> m;
+        auto const fixes = bench::rmc_counter::fixes;
+        for (auto _ : state)
+        {
+            bench::feed(m, input);
+        }
+        count(state, input, bench::rmc_counter::fixes - fixes);
+    }
+    BENCHMARK_TEMPLATE(BM_machine_parse_loop, 85)->ArgName("noisy")->Arg(0)->Arg(1);
+    BENCHMARK_TEMPLATE(BM_machine_parse_loop, 128)->ArgName("noisy")->Arg(0)->Arg(1);
+    BENCHMARK_TEMPLATE(BM_machine_parse_loop, 300)->ArgName("noisy")->Arg(0)->Arg(1);
+    BENCHMARK_TEMPLATE(BM_machine_parse_loop, 1024)->ArgName("noisy")->Arg(0)->Arg(1);
+    BENCHMARK_TEMPLATE(BM_machine_parse_loop, 4096)->ArgName("noisy")->Arg(0)->Arg(1);
+
+    // the chunks straight from the caller's memory, with only the sentences cut by a chunk end going through the ring
+    template <size_t bs>
+    void BM_machine_parse_span(benchmark::State & state)
+    {
+        auto const & input = stream(state);
+        auto const & sizes = bench::chunks();
+        serial::machine<bs, bench::rmc_counter> m;
+        auto const fixes = bench::rmc_counter::fixes;
+        for (auto _ : state)
+        {
+            auto data = input.data();
+            auto const last = data + input.size();
+            for (size_t i = 0; data != last; ++i)
+            {
+                auto const chunk = std::min(sizes[i % sizes.size()], size_t(last - data));
+                m.parse(data, chunk);
+                data += chunk;
+            }
+        }
+        count(state, input, bench::rmc_counter::fixes - fixes);
+    }
+    BENCHMARK_TEMPLATE(BM_machine_parse_span, 128)->ArgName("noisy")->Arg(0)->Arg(1);
+    BENCHMARK_TEMPLATE(BM_machine_parse_span, 300)->ArgName("noisy")->Arg(0)->Arg(1);
+    BENCHMARK_TEMPLATE(BM_machine_parse_span, 4096)->ArgName("noisy")->Arg(0)->Arg(1);
+
+    void BM_machine_parse_all(benchmark::State & state)
+    {
+        auto const & input = stream(state);
+        auto const & sizes = bench::chunks();
+        serial::machine<300, bench::rmc_counter> m;
+        auto const fixes = bench::rmc_counter::fixes;
+        for (auto _ : state)
+        {
+            auto data = input.data();
+            auto const last = data + input.size();
+            for (size_t i = 0; data != last; ++i)
+            {
+                auto const chunk = std::min(sizes[i % sizes.size()], size_t(last - data));
+                m.fill_data(data, chunk);
+                data += chunk;
+                m.parse_all();
+            }
+        }
+        count(state, input, bench::rmc_counter::fixes - fixes);
+    }
+    BENCHMARK(BM_machine_parse_all)->ArgName("noisy")->Arg(0)->Arg(1);
+}
+
+namespace
+{
+    // chunks of 1 to 8 bytes, as a UART interrupt hands them over
+    std::vector<size_t> const & small_chunks()
+    {
+        static std::vector<size_t> const sizes = []
+        {
+            std::mt19937 gen(8);
+            std::uniform_int_distribution<size_t> size(1, 8);
+            std::vector<size_t> v(4096);
+            for (auto & s : v)
+            {
+                s = size(gen);
+            }
+            return v;
+        }();
+        return sizes;
+    }
+
+    template <class PARSER, class PUSH>
+    void feed_small(benchmark::State & state, PARSER & parser, PUSH push)
+    {
+        auto const & input = stream(state);
+        auto const & sizes = small_chunks();
+        auto const fixes = bench::rmc_counter::fixes;
+        for (auto _ : state)
+        {
+            auto data = input.data();
+            auto const last = data + input.size();
+            for (size_t i = 0; data != last; ++i)
+            {
+                auto const chunk = std::min(sizes[i % sizes.size()], size_t(last - data));
+                push(parser, data, chunk);
+                data += chunk;
+            }
+        }
+        count(state, input, bench::rmc_counter::fixes - fixes);
+    }
+
+    // the span parse, every chunk ending within a sentence going through the ring
+    void BM_machine_small_chunks(benchmark::State & state)
+    {
+        serial::machine<300, bench::rmc_counter> m;
+        feed_small(state, m, [](auto & parser, char const * data, size_t n) { parser.parse(data, n); });
+    }
+    BENCHMARK(BM_machine_small_chunks)->ArgName("noisy")->Arg(0)->Arg(1);
+
+    // every byte once, whatever the chunks
+    void BM_push_decoder_small_chunks(benchmark::State & state)
+    {
+        serial::push_decoder<bench::rmc_counter> decoder;
+        feed_small(state, decoder, [](auto & parser, char const * data, size_t n) { parser.push(data, n); });
+    }
+    BENCHMARK(BM_push_decoder_small_chunks)->ArgName("noisy")->Arg(0)->Arg(1);
+}
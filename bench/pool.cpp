@@ -0,0 +1,49 @@
+#include <benchmark/benchmark.h>
+#include <pool.h>
+#include "streams.h"
+
+// Ports times threads: every port gets the clean stream in random chunks, submitted round robin from one thread, and the
+// time runs until all of it is parsed. Ranges are the ports and the threads.
+
+namespace
+{
+    struct block_traits : serial::default_traits
+    {
+        static constexpr serial::overflow_policy overflow = serial::overflow_policy::block;
+    };
+
+    struct fix_counter
+    {
+        size_t fixes = 0;
+        void operator()(serial::minmea_sentence_rmc const &) noexcept
+        {
+            ++fixes;
+        }
+    };
+
+    void BM_parser_pool(benchmark::State & state)
+    {
+        auto const ports = size_t(state.range(0));
+        auto const & input = bench::clean_stream();
+        auto const & sizes = bench::chunks();
+        serial::parser_pool<4096, fix_counter, block_traits> pool(ports, unsigned(state.range(1)));
+        for (auto _ : state)
+        {
+            std::vector<size_t> offsets(ports);
+            for (size_t i = 0, done = 0; done != ports; ++i)
+            {
+                auto const port = i % ports;
+                auto const offset = offsets[port];
+                if (offset == input.size())
+                    continue;
+                auto const chunk = std::min(sizes[i % sizes.size()], input.size() - offset);
+                pool.submit(port, input.data() + offset, chunk);
+                offsets[port] += chunk;
+                done += (offsets[port] == input.size());
+            }
+            pool.drain();
+        }
+        state.SetBytesProcessed(int64_t(state.iterations()) * input.size() * ports);
+    }
+    BENCHMARK(BM_parser_pool)->ArgNames({"ports", "threads"})->ArgsProduct({{1, 8, 64, 256}, {1, 2, 4, 8}})->UseRealTime();
+}
@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+#include <machine.h>
+
+// Delimiter search over a wrapped ring with no delimiters in it: the ring iterators the states used to walk
+// against the block scanner with the classifier the CPU gets and with the scalar one.
+
+namespace
+{
+    struct null_callback
+    {
+        static void callback(serial::minmea_sentence_rmc const &) {}
+    };
+
+    constexpr size_t ring_size = 4096;
+    using bench_machine = serial::machine<ring_size, null_callback>;
+
+    void fill_wrapped(bench_machine & m)
+    {
+        std::vector<char> const noise(ring_size - 1, 'G');
+        m.fill_data(noise.data(), ring_size / 2);
+        while (m.parse());
+        m.fill_data(noise.data(), noise.size());
+    }
+
+    void BM_find_dollar_ring_iterator(benchmark::State & state)
+    {
+        bench_machine m;
+        fill_wrapped(m);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(std::find(m.begin(), m.end(), '$'));
+        }
+        state.SetBytesProcessed(int64_t(state.iterations()) * m.size());
+    }
+    BENCHMARK(BM_find_dollar_ring_iterator);
+
+    void BM_find_crlf_ring_iterator(benchmark::State & state)
+    {
+        bench_machine m;
+        fill_wrapped(m);
+        std::array<char, 2> constexpr crlf_seq {'\x0D', '\x0A'};
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(std::search(m.begin(), m.end(), crlf_seq.begin(), crlf_seq.end()));
+        }
+        state.SetBytesProcessed(int64_t(state.iterations()) * m.size());
+    }
+    BENCHMARK(BM_find_crlf_ring_iterator);
+
+    void BM_find_delimiters(benchmark::State & state, serial::block_classifier classify)
+    {
+        bench_machine m;
+        fill_wrapped(m);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(find_delimiters(m.segments(), serial::dollar_delimiter | serial::crlf_delimiter | serial::star_delimiter, classify));
+        }
+        state.SetBytesProcessed(int64_t(state.iterations()) * m.size());
+    }
+    BENCHMARK_CAPTURE(BM_find_delimiters, dispatched, serial::classifier());
+    BENCHMARK_CAPTURE(BM_find_delimiters, scalar, serial::classify_scalar);
+}
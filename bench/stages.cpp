@@ -0,0 +1,132 @@
+#include <benchmark/benchmark.h>
+#include "streams.h"
+
+// The pipeline stage by stage. Every iteration fills the ring with garbage followed by one sentence and runs the first
+// stages over it: fill_data() alone, then Parse$State scanning the garbage, ParseIdState, ParseCrlfState searching the
+// sentence, ParseChecksumState and the decoding, so that the cost of a stage is the difference to the previous one.
+// Ranges are the ring size and whether the sentence wraps around the end of the buffer.
+
+namespace
+{
+    constexpr char const * sentence = bench::sentences[2];
+
+    template <size_t bs>
+    struct undecoded_machine : bench::staged_machine<bs>
+    {
+        void process() override {}
+    };
+
+    enum stage
+    {
+        fill,
+        dollar,
+        id,
+        crlf,
+        checksum,
+        decode
+    };
+
+    template <size_t bs, stage last>
+    void BM_stage(benchmark::State & state)
+    {
+        std::conditional_t<last == checksum, undecoded_machine<bs>, bench::staged_machine<bs>> m;
+        auto const size = std::strlen(sentence);
+        std::string input(bs - size, 'G');
+        input += sentence;
+
+        if (state.range(0)) // the sentence from 34 bytes before the end of the buffer on
+        {
+            m.fill_data(input.data(), 34);
+            while (m.parse());
+        }
+        for (auto _ : state)
+        {
+            m.fill_data(input.data(), bs);
+            for (int i = 0; i < last; ++i)
+            {
+                benchmark::DoNotOptimize(m.parse());
+            }
+            m.restart();
+        }
+        state.SetBytesProcessed(int64_t(state.iterations()) * bs);
+    }
+
+#define STAGE_BENCHMARKS(bs) \
+    BENCHMARK_TEMPLATE(BM_stage, bs, fill)->ArgName("wrapped")->Arg(0)->Arg(1); \
+    BENCHMARK_TEMPLATE(BM_stage, bs, dollar)->ArgName("wrapped")->Arg(0)->Arg(1); \
+    BENCHMARK_TEMPLATE(BM_stage, bs, id)->ArgName("wrapped")->Arg(0)->Arg(1); \
+    BENCHMARK_TEMPLATE(BM_stage, bs, crlf)->ArgName("wrapped")->Arg(0)->Arg(1); \
+    BENCHMARK_TEMPLATE(BM_stage, bs, checksum)->ArgName("wrapped")->Arg(0)->Arg(1); \
+    BENCHMARK_TEMPLATE(BM_stage, bs, decode)->ArgName("wrapped")->Arg(0)->Arg(1)
+
+    STAGE_BENCHMARKS(85);
+    STAGE_BENCHMARKS(128);
+    STAGE_BENCHMARKS(300);
+    STAGE_BENCHMARKS(1024);
+    STAGE_BENCHMARKS(4096);
+
+    // the field decoding alone, over contiguous memory
+    void BM_minmea_parse_rmc(benchmark::State & state)
+    {
+        auto const first = sentence + 7;
+        auto const last = sentence + std::strlen(sentence) - 2;
+        serial::minmea_sentence_rmc frame {};
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(serial::minmea_parse_rmc(&frame, first, last));
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_minmea_parse_rmc);
+
+    // time, validity, position and speed only, the course, the date and the variation skipped over
+    void BM_minmea_parse_rmc_subset(benchmark::State & state)
+    {
+        namespace f = serial::rmc_field;
+        auto const first = sentence + 7;
+        auto const last = sentence + std::strlen(sentence) - 2;
+        serial::rmc_subset<f::time | f::validity | f::latitude | f::longitude | f::speed> frame {};
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(serial::minmea_parse(&frame, first, last));
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_minmea_parse_rmc_subset);
+
+    // the checksum of a sentence, a byte at a time and a word at a time
+    void BM_checksum_bytewise(benchmark::State & state)
+    {
+        std::string const input(sentence);
+        auto const size = input.size() - 6;
+        for (auto _ : state)
+        {
+            auto data = input.data();
+            benchmark::DoNotOptimize(data);
+            uint8_t sum = 0;
+            for (size_t i = 1; i < size; ++i)
+            {
+                sum ^= uint8_t(data[i]);
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetBytesProcessed(int64_t(state.iterations()) * size);
+    }
+    BENCHMARK(BM_checksum_bytewise);
+
+    void BM_checksum_wordwise(benchmark::State & state)
+    {
+        std::string const input(sentence);
+        auto const size = input.size() - 6;
+        for (auto _ : state)
+        {
+            auto data = input.data();
+            benchmark::DoNotOptimize(data);
+            benchmark::DoNotOptimize(serial::xor_bytes(data + 1, size - 1));
+        }
+        state.SetBytesProcessed(int64_t(state.iterations()) * size);
+    }
+    BENCHMARK(BM_checksum_wordwise);
+}
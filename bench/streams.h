@@ -0,0 +1,137 @@
+#pragma once
+
+#include <machine.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// Inputs shared by the benchmarks: recorded-like streams and the random chunking main.cpp feeds the machine with.
+
+namespace bench
+{
+    constexpr char const * sentences[] {
+        "$GPRMC,072633.327,A,5230.215,N,01324.658,E,847.2,283.3,140220,000.0,W*74\x0D\x0A",
+        "$GPRMC,081836.000,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*75\x0D\x0A",
+        "$GPRMC,225446,A,4916.45,N,12311.12,W,000.5,054.7,191119,020.3,E*6D\x0D\x0A",
+        "$GPRMC,072640.327,A,5230.331,N,01324.153,E,000.0,000.0,140220,000.0,W*78\x0D\x0A"
+    };
+
+    constexpr size_t stream_sentences = 4000;
+
+    // valid sentences back to back
+    inline std::string const & clean_stream()
+    {
+        static std::string const s = []
+        {
+            std::string s;
+            for (size_t i = 0; i < stream_sentences; ++i)
+            {
+                s += sentences[i % 4];
+            }
+            return s;
+        }();
+        return s;
+    }
+
+    // the same with runs of garbage, bad checksums, sentences with no CR-LF and sentences nobody is registered for
+    inline std::string const & noisy_stream()
+    {
+        static std::string const s = []
+        {
+            std::mt19937 gen(11);
+            std::uniform_int_distribution<int> pick(0, 9);
+            std::uniform_int_distribution<int> byte(' ', '~');
+            std::string s;
+            for (size_t i = 0; i < stream_sentences; ++i)
+            {
+                std::string sentence = sentences[i % 4];
+                switch (pick(gen))
+                {
+                    case 0:
+                        for (auto n = pick(gen) * 8; n; --n)
+                            s += char(byte(gen));
+                        break;
+                    case 1:
+                        sentence[20] ^= 1; // checksum mismatch
+                        break;
+                    case 2:
+                        sentence.resize(sentence.size() - 2);
+                        break;
+                    case 3:
+                        s += "$GPTXT,01,01,02,ANTSTATUS=OK*3B\x0D\x0A";
+                        break;
+                    default:
+                        break;
+                }
+                s += sentence;
+            }
+            return s;
+        }();
+        return s;
+    }
+
+    // chunk sizes of 10 to 100 bytes, as a serial port read returns them
+    inline std::vector<size_t> const & chunks()
+    {
+        static std::vector<size_t> const sizes = []
+        {
+            std::mt19937 gen(7);
+            std::uniform_int_distribution<size_t> dis(10, 100);
+            std::vector<size_t> v(4096);
+            for (auto & size : v)
+            {
+                size = dis(gen);
+            }
+            return v;
+        }();
+        return sizes;
+    }
+
+    struct rmc_counter
+    {
+        static inline size_t fixes = 0;
+        static void callback(serial::minmea_sentence_rmc const &)
+        {
+            ++fixes;
+        }
+    };
+
+    // a machine whose state can be set from outside, to run single stages over the same bytes again
+    template <size_t bs, class Callback = rmc_counter>
+    struct staged_machine : serial::machine<bs, Callback>
+    {
+        using serial::machine<bs, Callback>::current_state;
+
+        // drops the bytes and the sentence in flight
+        void restart() noexcept
+        {
+            this->align();
+            if (current_state == serial::state_id::parse_checksum)
+                current_state = serial::state_id::parse_$; // its cleanup would roll the ring back
+            else
+                this->set_state(serial::state_id::parse_$);
+        }
+    };
+
+    // Feeds the stream in chunks that fit the ring and runs the machine after every one of them. A sentence that does
+    // not fit the ring is dropped.
+    template <class MACHINE>
+    void feed(MACHINE & m, std::string const & stream)
+    {
+        auto const & sizes = chunks();
+        auto data = stream.data();
+        auto const last = data + stream.size();
+        for (size_t i = 0; data != last; ++i)
+        {
+            auto const chunk = std::min({sizes[i % sizes.size()], m.available(), size_t(last - data)});
+            if (!chunk)
+            {
+                m.restart();
+                continue;
+            }
+            m.fill_data(data, chunk);
+            data += chunk;
+            while (m.parse());
+        }
+    }
+}
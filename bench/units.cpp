@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+#include <units.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Conversion of a batch of RMC frames to rmc_fix: by dividing by the scales, as consumers did, and by the reciprocal
+// tables of units.h. Range is the batch size.
+
+namespace
+{
+    std::vector<serial::minmea_sentence_rmc> frames(size_t n)
+    {
+        std::mt19937 gen(19);
+        std::uniform_int_distribution<int_least32_t> minutes(0, 599999);
+        std::vector<serial::minmea_sentence_rmc> result(n);
+        for (auto & rmc : result)
+        {
+            rmc.time = serial::minmea_time {8, 18, 36, 0};
+            rmc.valid = true;
+            rmc.latitude = serial::minmea_float {3700000 + minutes(gen), 10000};
+            rmc.longitude = serial::minmea_float {-(14500000 + minutes(gen)), 10000};
+            rmc.speed = serial::minmea_float {minutes(gen) % 1000, 10};
+            rmc.course = serial::minmea_float {minutes(gen) % 3600, 10};
+            rmc.date = serial::minmea_date {13, 9, 19};
+            rmc.variation = serial::minmea_float {113, 10};
+        }
+        return result;
+    }
+
+    double divided_degrees(serial::minmea_float f)
+    {
+        double const raw = double(f.value) / f.scale;
+        double const degrees = std::trunc(raw / 100);
+        return degrees + (raw - degrees * 100) / 60;
+    }
+
+    void BM_fix_divide(benchmark::State & state)
+    {
+        auto const in = frames(size_t(state.range(0)));
+        std::vector<serial::rmc_fix> out(in.size());
+        for (auto _ : state)
+        {
+            for (size_t i = 0; i < in.size(); ++i)
+            {
+                auto const & rmc = in[i];
+                out[i] = serial::rmc_fix {serial::to_time_point(rmc.date, rmc.time), rmc.valid,
+                                          divided_degrees(rmc.latitude), divided_degrees(rmc.longitude),
+                                          float(double(rmc.speed.value) / rmc.speed.scale * 1852 / 3600),
+                                          float(double(rmc.course.value) / rmc.course.scale),
+                                          float(double(rmc.variation.value) / rmc.variation.scale)};
+            }
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+    }
+    BENCHMARK(BM_fix_divide)->Arg(64)->Arg(1024);
+
+    void BM_fix_tables(benchmark::State & state)
+    {
+        auto const in = frames(size_t(state.range(0)));
+        std::vector<serial::rmc_fix> out(in.size());
+        for (auto _ : state)
+        {
+            serial::to_fixes({in.data(), in.size()}, {out.data(), out.size()});
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+    }
+    BENCHMARK(BM_fix_tables)->Arg(64)->Arg(1024);
+}
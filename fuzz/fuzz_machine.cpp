@@ -0,0 +1,260 @@
+#include <machine.h>
+#include <push.h>
+#include "reference.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// Differential fuzzing of the machine. A stream is cut into chunks and fed both to the ring, a chunk at a time, and to
+// the span parse; every RMC frame either delivers must be the one the reference decodes from the same sentence framed
+// in the flat buffer, in the same order. The push decoder is held to the same frames on the streams it frames as the
+// machine does. A mismatch aborts with the input written to fuzz-mismatch.bin.
+//
+// Built with -DRMC_LIBFUZZER and -fsanitize=fuzzer it is a libFuzzer target, whose first input byte seeds the chunking.
+// Built standalone it generates streams of valid sentences and corrupts them:
+//   fuzz_machine [iterations [seed]]   random streams, 10000 by default
+//   fuzz_machine <file>...             the inputs of a corpus or of a crash, as libFuzzer takes them
+
+namespace
+{
+    constexpr size_t ring_size = 1024;
+    constexpr size_t max_chunk = 256; // a chunk and a sentence in flight always fit, nothing is dropped
+
+    struct rmc_log
+    {
+        std::vector<serial::minmea_sentence_rmc> * frames;
+        void operator()(serial::minmea_sentence_rmc const & rmc) const
+        {
+            frames->push_back(rmc);
+        }
+    };
+
+    bool same(serial::minmea_float a, serial::minmea_float b)
+    {
+        return a.value == b.value && a.scale == b.scale;
+    }
+
+    bool same(serial::minmea_sentence_rmc const & a, serial::minmea_sentence_rmc const & b)
+    {
+        return a.time.hours == b.time.hours && a.time.minutes == b.time.minutes && a.time.seconds == b.time.seconds &&
+               a.time.microseconds == b.time.microseconds && a.valid == b.valid && same(a.latitude, b.latitude) &&
+               same(a.longitude, b.longitude) && same(a.speed, b.speed) && same(a.course, b.course) &&
+               a.date.day == b.date.day && a.date.month == b.date.month && a.date.year == b.date.year &&
+               same(a.variation, b.variation);
+    }
+
+    // the RMC sentences the reference frames and checks in the flat buffer, their fields decoded by it
+    std::vector<serial::minmea_sentence_rmc> reference_frames(char const * first, char const * last)
+    {
+        std::vector<serial::minmea_sentence_rmc> frames;
+        for (auto const & fields : reference::rmc_fields(first, last))
+        {
+            serial::minmea_sentence_rmc frame {};
+            if (reference::parse_rmc(&frame, fields.c_str()))
+            {
+                frames.push_back(frame);
+            }
+        }
+        return frames;
+    }
+
+    // whether the push decoder frames the stream as the machine does: they part ways at a '$' within a sentence, where
+    // the push decoder starts afresh, and at a '*', cr or lf within its fields, where the push decoder ends it
+    bool same_framing(char const * first, char const * last)
+    {
+        std::string const stream(first, last);
+        for (size_t line = 0; line < stream.size();)
+        {
+            auto const crlf = std::min(stream.find("\x0D\x0A", line), stream.size());
+            auto const dollar = stream.find('$', line);
+            if (dollar < crlf)
+            {
+                auto const body = stream.substr(dollar + 1, crlf - dollar - 1);
+                auto const star = body.find('*');
+                if (body.find_first_of("$\x0D\x0A") != std::string::npos ||
+                    (star != std::string::npos && star + 3 != body.size()))
+                {
+                    return false;
+                }
+            }
+            line = crlf + 2;
+        }
+        return true;
+    }
+
+    [[noreturn]] void mismatch(char const * path, size_t frame, uint8_t seed, char const * data, size_t size)
+    {
+        std::fprintf(stderr, "the %s differs from the reference at frame %zu\n", path, frame);
+        if (auto const out = std::fopen("fuzz-mismatch.bin", "wb"))
+        {
+            std::fputc(seed, out);
+            std::fwrite(data, 1, size, out);
+            std::fclose(out);
+        }
+        std::abort();
+    }
+
+    void compare(char const * path, std::vector<serial::minmea_sentence_rmc> const & frames,
+                 std::vector<serial::minmea_sentence_rmc> const & expected, uint8_t seed, char const * data, size_t size)
+    {
+        for (size_t i = 0; i < std::max(frames.size(), expected.size()); ++i)
+        {
+            if (i == frames.size() || i == expected.size() || !same(frames[i], expected[i]))
+            {
+                mismatch(path, i, seed, data, size);
+            }
+        }
+    }
+
+    // true if the push decoder was compared too
+    bool check(uint8_t seed, char const * data, size_t size)
+    {
+        auto const expected = reference_frames(data, data + size);
+
+        std::vector<serial::minmea_sentence_rmc> ring_frames, span_frames, push_frames;
+        serial::machine<ring_size, rmc_log> ring(rmc_log {&ring_frames});
+        serial::machine<ring_size, rmc_log> span(rmc_log {&span_frames});
+        serial::push_decoder<rmc_log> push(rmc_log {&push_frames});
+        std::minstd_rand gen(seed + 1u);
+        std::uniform_int_distribution<size_t> chunk(1, max_chunk);
+        for (size_t offset = 0, n = 0; offset < size; offset += n)
+        {
+            n = std::min(chunk(gen), size - offset);
+            ring.fill_data(data + offset, n);
+            ring.parse_all();
+            span.parse(data + offset, n);
+            push.push(data + offset, n);
+        }
+        compare("ring", ring_frames, expected, seed, data, size);
+        compare("span parse", span_frames, expected, seed, data, size);
+        if (!same_framing(data, data + size))
+        {
+            return false;
+        }
+        compare("push decoder", push_frames, expected, seed, data, size);
+        return true;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(uint8_t const * data, size_t size)
+{
+    if (size != 0)
+    {
+        check(data[0], reinterpret_cast<char const *>(data) + 1, size - 1);
+    }
+    return 0;
+}
+
+#ifndef RMC_LIBFUZZER
+namespace
+{
+    template <class GEN>
+    std::string digits(GEN & gen, int n)
+    {
+        std::string s;
+        for (int i = 0; i < n; ++i)
+        {
+            s += char('0' + gen() % 10);
+        }
+        return s;
+    }
+
+    // a field as receivers write it, now and then empty
+    template <class GEN>
+    std::string field(GEN & gen, std::string const & value)
+    {
+        return (gen() % 8) ? value : std::string();
+    }
+
+    template <class GEN>
+    std::string sentence(GEN & gen)
+    {
+        std::string body = (gen() % 4) ? "GPRMC" : "GPGGA";
+        body += ',' + field(gen, digits(gen, 6) + ((gen() % 2) ? '.' + digits(gen, gen() % 5) : std::string()));
+        body += ',' + field(gen, (gen() % 2) ? "A" : "V");
+        body += ',' + field(gen, digits(gen, 4) + '.' + digits(gen, gen() % 9)) + ',' + field(gen, (gen() % 2) ? "N" : "S");
+        body += ',' + field(gen, digits(gen, 5) + '.' + digits(gen, gen() % 9)) + ',' + field(gen, (gen() % 2) ? "E" : "W");
+        body += ',' + field(gen, digits(gen, 3) + '.' + digits(gen, 1)) + ',' + field(gen, digits(gen, 3) + '.' + digits(gen, 1));
+        body += ',' + field(gen, digits(gen, 6)) + ',' + field(gen, digits(gen, 3) + '.' + digits(gen, 1));
+        body += ',' + field(gen, (gen() % 2) ? "E" : "W");
+        if (gen() % 4 == 0)
+        {
+            body.resize(gen() % body.size()); // fields left out
+        }
+        uint8_t sum = 0;
+        for (char c : body)
+        {
+            sum ^= uint8_t(c);
+        }
+        char checksum[4];
+        std::snprintf(checksum, sizeof(checksum), "%02X", sum);
+        return '$' + body + '*' + checksum + "\x0D\x0A";
+    }
+
+    // bytes flipped, delimiters put in, bytes left out, runs of garbage and sentences run together
+    template <class GEN>
+    void corrupt(GEN & gen, std::string & s)
+    {
+        char const delimiters[] = "$*,\x0D\x0A -.";
+        for (auto n = gen() % 4; n && !s.empty(); --n)
+        {
+            auto const at = gen() % s.size();
+            switch (gen() % 5)
+            {
+                case 0: s[at] = char(gen()); break;
+                case 1: s.insert(s.begin() + at, delimiters[gen() % (sizeof(delimiters) - 1)]); break;
+                case 2: s.erase(at, 1 + gen() % 3); break;
+                case 3: s.insert(at, std::string(gen() % 200, char('0' + gen() % 10))); break;
+                default: s[at] = delimiters[gen() % (sizeof(delimiters) - 1)]; break;
+            }
+        }
+    }
+
+    std::string stream(std::mt19937 & gen)
+    {
+        std::string s;
+        for (auto n = 1 + gen() % 12; n; --n)
+        {
+            auto one = sentence(gen);
+            if (gen() % 3 == 0)
+            {
+                corrupt(gen, one);
+            }
+            s += one;
+        }
+        return s;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    char * end = nullptr;
+    auto const iterations = (argc > 1) ? std::strtoul(argv[1], &end, 10) : 10000ul;
+    if (argc > 1 && *end != '\0')
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::ifstream in(argv[i], std::ios::binary);
+            std::string const input((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            LLVMFuzzerTestOneInput(reinterpret_cast<uint8_t const *>(input.data()), input.size());
+        }
+        std::printf("%d inputs match the reference\n", argc - 1);
+        return 0;
+    }
+
+    std::mt19937 gen((argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 24u);
+    size_t frames = 0, pushed = 0;
+    for (unsigned long i = 0; i < iterations; ++i)
+    {
+        auto const s = stream(gen);
+        auto const seed = uint8_t(gen());
+        frames += reference_frames(s.data(), s.data() + s.size()).size();
+        pushed += check(seed, s.data(), s.size());
+    }
+    std::printf("%lu streams, %zu frames match the reference, %zu streams through the push decoder too\n", iterations, frames, pushed);
+    return 0;
+}
+#endif
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <tokenizer.h>
+#include <cctype>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// The reference the decoders are held to: minmea_scan of Kosma Moczek's minmea as it was before the schemas, with its
+// format string, over a flat NUL-terminated buffer. Fields past the last comma decode to their defaults, as they did in
+// the copy the tokenizer started from. It is slow and plain on purpose.
+
+namespace reference
+{
+    using serial::minmea_float;
+    using serial::minmea_date;
+    using serial::minmea_time;
+    using serial::minmea_sentence_rmc;
+
+    inline bool isfield(char c)
+    {
+        return isprint((unsigned char) c) && c != ',' && c != '*';
+    }
+
+    inline bool scan(const char *sentence, const char *format, ...)
+    {
+        bool result = false;
+        va_list ap;
+        va_start(ap, format);
+
+        const char *field = sentence;
+#define next_field() \
+    do { \
+        while (isfield(*sentence)) \
+            sentence++; \
+        if (*sentence == ',') { \
+            sentence++; \
+            field = sentence; \
+        } else { \
+            field = NULL; \
+        } \
+    } while (0)
+
+        while (*format) {
+            char type = *format++;
+
+            switch (type) {
+                case 'c': {
+                    char value = '\0';
+                    if (field && isfield(*field))
+                        value = *field;
+                    *va_arg(ap, char *) = value;
+                } break;
+
+                case 'd': {
+                    int value = 0;
+                    if (field && isfield(*field)) {
+                        switch (*field) {
+                            case 'N':
+                            case 'E':
+                                value = 1;
+                                break;
+                            case 'S':
+                            case 'W':
+                                value = -1;
+                                break;
+                            default:
+                                goto parse_error;
+                        }
+                    }
+                    *va_arg(ap, int *) = value;
+                } break;
+
+                case 'f': {
+                    int sign = 0;
+                    int_least32_t value = -1;
+                    int_least32_t scale = 0;
+
+                    if (field) {
+                        while (isfield(*field)) {
+                            if (*field == '+' && !sign && value == -1) {
+                                sign = 1;
+                            } else if (*field == '-' && !sign && value == -1) {
+                                sign = -1;
+                            } else if (isdigit((unsigned char) *field)) {
+                                int digit = *field - '0';
+                                if (value == -1)
+                                    value = 0;
+                                if (value > (INT_LEAST32_MAX-digit) / 10) {
+                                    if (scale)
+                                        break;
+                                    else
+                                        goto parse_error;
+                                }
+                                value = (10 * value) + digit;
+                                if (scale)
+                                    scale *= 10;
+                            } else if (*field == '.' && scale == 0) {
+                                scale = 1;
+                            } else if (*field == ' ') {
+                                if (sign != 0 || value != -1 || scale != 0)
+                                    goto parse_error;
+                            } else {
+                                goto parse_error;
+                            }
+                            field++;
+                        }
+                    }
+
+                    if ((sign || scale) && value == -1)
+                        goto parse_error;
+
+                    if (value == -1) {
+                        value = 0;
+                        scale = 0;
+                    } else if (scale == 0) {
+                        scale = 1;
+                    }
+                    if (sign)
+                        value *= sign;
+
+                    *va_arg(ap, struct minmea_float *) = minmea_float {value, scale};
+                } break;
+
+                case 'D': {
+                    struct minmea_date *date = va_arg(ap, struct minmea_date *);
+                    int d = -1, m = -1, y = -1;
+
+                    if (field && isfield(*field)) {
+                        for (int f=0; f<6; f++)
+                            if (!isdigit((unsigned char) field[f]))
+                                goto parse_error;
+
+                        char dArr[] = {field[0], field[1], '\0'};
+                        char mArr[] = {field[2], field[3], '\0'};
+                        char yArr[] = {field[4], field[5], '\0'};
+                        d = strtol(dArr, NULL, 10);
+                        m = strtol(mArr, NULL, 10);
+                        y = strtol(yArr, NULL, 10);
+                    }
+
+                    date->day = d;
+                    date->month = m;
+                    date->year = y;
+                } break;
+
+                case 'T': {
+                    struct minmea_time *time_ = va_arg(ap, struct minmea_time *);
+                    int h = -1, i = -1, s = -1, u = -1;
+
+                    if (field && isfield(*field)) {
+                        for (int f=0; f<6; f++)
+                            if (!isdigit((unsigned char) field[f]))
+                                goto parse_error;
+
+                        char hArr[] = {field[0], field[1], '\0'};
+                        char iArr[] = {field[2], field[3], '\0'};
+                        char sArr[] = {field[4], field[5], '\0'};
+                        h = strtol(hArr, NULL, 10);
+                        i = strtol(iArr, NULL, 10);
+                        s = strtol(sArr, NULL, 10);
+                        field += 6;
+
+                        if (*field++ == '.') {
+                            uint32_t value = 0;
+                            uint32_t scale = 1000000LU;
+                            while (isdigit((unsigned char) *field) && scale > 1) {
+                                value = (value * 10) + (*field++ - '0');
+                                scale /= 10;
+                            }
+                            u = value * scale;
+                        } else {
+                            u = 0;
+                        }
+                    }
+
+                    time_->hours = h;
+                    time_->minutes = i;
+                    time_->seconds = s;
+                    time_->microseconds = u;
+                } break;
+
+                default:
+                    goto parse_error;
+            }
+
+            next_field();
+        }
+
+        result = true;
+
+    parse_error:
+        va_end(ap);
+        return result;
+#undef next_field
+    }
+
+    // fields is the NUL-terminated text from the first field on, past "GPRMC,"
+    inline bool parse_rmc(struct minmea_sentence_rmc *frame, const char *fields)
+    {
+        char validity;
+        int latitude_direction;
+        int longitude_direction;
+        int variation_direction;
+        if (!scan(fields, "TcfdfdffDfd",
+                  &frame->time,
+                  &validity,
+                  &frame->latitude, &latitude_direction,
+                  &frame->longitude, &longitude_direction,
+                  &frame->speed,
+                  &frame->course,
+                  &frame->date,
+                  &frame->variation, &variation_direction))
+            return false;
+
+        frame->valid = (validity == 'A');
+        frame->latitude.value *= latitude_direction;
+        frame->longitude.value *= longitude_direction;
+        frame->variation.value *= variation_direction;
+        return true;
+    }
+
+    inline int hexdigit(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        return -1;
+    }
+
+    // The field text of every RMC sentence of a flat stream that has its checksum right, in order, framed the way the
+    // machine frames: a sentence runs from a '$' to the first CR-LF past its id, at most max_size bytes from past the
+    // '$' up to the CR, and one longer is searched again from halfway through. The framing stops at a sentence the
+    // stream ends in.
+    inline std::vector<std::string> rmc_fields(const char *first, const char *last, long max_size = 82)
+    {
+        std::vector<std::string> fields;
+        const char *p = first;
+        for (;;) {
+            while (p != last && *p != '$')
+                p++;
+            if (last - p <= 5)
+                break;
+            const char *start = p + 1;
+            if (start[0] == 'P' || memcmp(start + 2, "RMC", 3) != 0) {
+                p = start; /* not asked for, the next '$' may be within it */
+                continue;
+            }
+
+            const char *cr = start + 5;
+            while (last - cr >= 2 && !(cr[0] == '\r' && cr[1] == '\n'))
+                cr++;
+            if (last - cr < 2) {
+                if ((last - 1) - start > max_size) {
+                    p = start + max_size / 2;
+                    continue;
+                }
+                break;
+            }
+            if (cr - start > max_size) {
+                p = start + max_size / 2;
+                continue;
+            }
+            p = cr + 2;
+            if (cr[-3] != '*')
+                continue;
+
+            int hi = hexdigit(cr[-2]);
+            int lo = hexdigit(cr[-1]);
+            unsigned char sum = 0;
+            for (const char *c = start; c != cr - 3; c++)
+                sum ^= (unsigned char) *c;
+            if (hi < 0 || lo < 0 || sum != hi * 16 + lo)
+                continue;
+            fields.emplace_back(start + 6, cr); /* past "GPRMC," up to the CR */
+        }
+        return fields;
+    }
+}
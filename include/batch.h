@@ -0,0 +1,59 @@
+#pragma once
+
+#include <sentence.h>
+#include <fields.h>
+#include <span.h>
+
+// Bulk decoding of recorded data: the frames of one sentence type, or an rmc_subset, are written one after another into
+// an array the caller supplies, with no callback per frame.
+
+namespace serial
+{
+    struct batch_result
+    {
+        size_t decoded;         // frames written
+        size_t checksum_failed;
+        size_t malformed;       // no checksum field, no CR-LF in time, or fields that do not decode
+        size_t consumed;        // bytes done with; a trailing partial sentence or the rest after a full array are not
+    };
+
+    template <class FRAME>
+    [[nodiscard]] batch_result parse_batch(char const * data, size_t n, span<FRAME> out) noexcept
+    {
+        static_assert(sentence_id_of<FRAME> != sentence_id::unknown, "not a frame of a known sentence");
+
+        batch_result result {};
+        auto const last = data + n;
+        auto it = data;
+        while ((it != last) && (result.decoded != out.size()))
+        {
+            auto const sentence = next_sentence(it, last, [](sentence_id id) { return id == sentence_id_of<FRAME>; });
+            if (sentence.status == sentence_status::partial)
+            {
+                it = sentence.next;
+                break;
+            }
+            switch (sentence.status)
+            {
+                case sentence_status::accepted:
+                    if (minmea_parse(&out[result.decoded], sentence.begin + 6, sentence.end))
+                        ++result.decoded;
+                    else
+                        ++result.malformed;
+                    break;
+                case sentence_status::checksum_failed:
+                    ++result.checksum_failed;
+                    break;
+                case sentence_status::malformed:
+                case sentence_status::oversize:
+                    ++result.malformed;
+                    break;
+                default:
+                    break;
+            }
+            it = sentence.next;
+        }
+        result.consumed = it - data;
+        return result;
+    }
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <callback.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Decoding of large recordings on all cores. The data is cut into ranges at the first line start past every multiple of
+// the range size, so the ranges hold whole lines and the framing sees each of them as it would in one pass. The ranges
+// are decoded by a pool of threads and their frames are handed to the callback on the calling thread in data order.
+
+namespace serial
+{
+    // the offset right after the first CR-LF that ends at pos or later, or n if there is none; 0 for pos 0
+    [[nodiscard]] inline size_t line_start(char const * data, size_t n, size_t pos) noexcept
+    {
+        if (pos == 0)
+        {
+            return 0;
+        }
+        auto const last = data + n;
+        auto cr = data + std::min(pos - std::min<size_t>(pos, 2), n);
+        while ((cr = static_cast<char const *>(std::memchr(cr, '\x0D', last - cr))) && (cr + 1 != last))
+        {
+            if (cr[1] == '\x0A')
+            {
+                return cr + 2 - data;
+            }
+            ++cr;
+        }
+        return n;
+    }
+
+    // a decoded frame, or the text of a proprietary sentence kept past the range it was read with
+    using bulk_frame = std::variant<any_sentence, std::string>;
+
+    // decodes the sentences of whole lines the callback takes, in order
+    template <class Callback>
+    void decode_lines(char const * first, char const * last, std::vector<bulk_frame> & frames)
+    {
+        while (first != last)
+        {
+            auto const sentence = next_sentence(first, last, registered<Callback>);
+            if (sentence.status == sentence_status::partial)
+            {
+                break;
+            }
+            if (sentence.status == sentence_status::accepted)
+            {
+                if (sentence.id == sentence_id::proprietary)
+                {
+                    frames.emplace_back(std::in_place_type<std::string>, sentence.begin, sentence.end);
+                } else
+                {
+                    visit_sentence(sentence.id, [&frames, &sentence](auto tag) // typed on the way out, by deliver()
+                    {
+                        using frame_type = typename decltype(tag)::type;
+                        if constexpr (wants_frame<Callback, frame_type>)
+                        {
+                            frame_type frame {};
+                            if (minmea_parse(&frame, sentence.begin + 6, sentence.end))
+                            {
+                                frames.emplace_back(std::in_place_type<any_sentence>, frame);
+                            }
+                        }
+                    });
+                }
+            }
+            first = sentence.next;
+        }
+    }
+
+    template <class Callback>
+    class bulk_decoder
+    {
+        static_assert(!takes_some_rmc_subset<Callback>, "rmc_subset frames come from a machine with their fields in its traits");
+
+        unsigned threads_;
+        size_t range_size_;
+
+    public:
+        explicit bulk_decoder(unsigned threads = std::thread::hardware_concurrency(), size_t range_size = size_t {1} << 22u)
+                : threads_(std::max(threads, 1u)), range_size_(std::max<size_t>(range_size, 1))
+        {}
+
+        void decode(char const * data, size_t n, Callback & callback) const
+        {
+            run(ranges(n), [this, data, n](size_t k, std::vector<bulk_frame> & frames)
+            {
+                auto const first = line_start(data, n, k * range_size_);
+                auto const last = line_start(data, n, std::min(n, (k + 1) * range_size_));
+                decode_lines<Callback>(data + first, data + last, frames);
+            }, callback);
+        }
+
+        // Reads the ranges of a file with pread(), each worker on its own, past the range end up to the line start there.
+        // Returns false if the file can not be opened.
+        bool decode_file(char const * path, Callback & callback) const
+        {
+            auto const fd = ::open(path, O_RDONLY);
+            struct stat st {};
+            if ((fd < 0) || (::fstat(fd, &st) != 0))
+            {
+                if (fd >= 0)
+                    ::close(fd);
+                return false;
+            }
+
+            auto const n = static_cast<size_t>(st.st_size);
+            run(ranges(n), [this, fd, n](size_t k, std::vector<bulk_frame> & frames)
+            {
+                auto const from = (k == 0) ? 0 : k * range_size_ - 2; // the CR-LF that may end right at the range start
+                auto const to = std::min(n, (k + 1) * range_size_);
+                std::vector<char> bytes;
+                auto size = std::min(n, to + max_sentence_size) - from;
+                size_t first, last;
+                for (;;)
+                {
+                    auto const have = bytes.size();
+                    bytes.resize(size);
+                    bytes.resize(have + read_at(fd, bytes.data() + have, size - have, from + have));
+                    first = line_start(bytes.data(), bytes.size(), k * range_size_ - from);
+                    last = line_start(bytes.data(), bytes.size(), to - from);
+                    if ((last != bytes.size()) || (from + bytes.size() >= n) || (bytes.size() < size))
+                        break;
+                    size = std::min(n - from, 2 * size); // a long run without line ends
+                }
+                decode_lines<Callback>(bytes.data() + first, bytes.data() + last, frames);
+            }, callback);
+            ::close(fd);
+            return true;
+        }
+
+    private:
+        [[nodiscard]] size_t ranges(size_t n) const noexcept
+        {
+            return (n + range_size_ - 1) / range_size_;
+        }
+
+        static size_t read_at(int fd, char * to, size_t count, size_t offset) noexcept
+        {
+            size_t done = 0;
+            while (done != count)
+            {
+                auto const got = ::pread(fd, to + done, count - done, static_cast<off_t>(offset + done));
+                if (got <= 0)
+                    break;
+                done += static_cast<size_t>(got);
+            }
+            return done;
+        }
+
+        // The workers take ranges in order and stay at most two ranges per thread ahead of the range being handed out,
+        // so the frames held at a time do not depend on the data size.
+        template <class WORK>
+        void run(size_t ranges, WORK const & work, Callback & callback) const
+        {
+            size_t const window = 2 * threads_;
+            std::vector<std::vector<bulk_frame>> results(window);
+            std::vector<size_t> finished(window, ranges);
+            std::mutex mutex;
+            std::condition_variable changed;
+            size_t taken = 0;
+            size_t emitted = 0;
+
+            auto const worker = [&]
+            {
+                for (;;)
+                {
+                    size_t k;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        changed.wait(lock, [&] { return (taken == ranges) || (taken < emitted + window); });
+                        if (taken == ranges)
+                            return;
+                        k = taken++;
+                    }
+                    std::vector<bulk_frame> frames;
+                    work(k, frames);
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        results[k % window] = std::move(frames);
+                        finished[k % window] = k;
+                    }
+                    changed.notify_all();
+                }
+            };
+
+            // Stops the workers and joins them, also when the callback throws: they run out of ranges to take instead
+            // of waiting for the frames handed out to make room.
+            struct workers
+            {
+                std::mutex & mutex;
+                std::condition_variable & changed;
+                size_t & taken;
+                size_t const ranges;
+                std::vector<std::thread> threads;
+
+                ~workers()
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        taken = ranges;
+                    }
+                    changed.notify_all();
+                    for (auto & thread : threads)
+                    {
+                        thread.join();
+                    }
+                }
+            } pool {mutex, changed, taken, ranges, {}};
+            for (unsigned i = 0; i < std::min<size_t>(threads_, ranges); ++i)
+            {
+                pool.threads.emplace_back(worker);
+            }
+            for (; emitted != ranges;)
+            {
+                std::vector<bulk_frame> frames;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&] { return finished[emitted % window] == emitted; });
+                    frames = std::move(results[emitted % window]);
+                    ++emitted;
+                }
+                changed.notify_all();
+                for (auto const & frame : frames)
+                {
+                    emit(callback, frame);
+                }
+            }
+        }
+
+        static void emit(Callback & callback, bulk_frame const & frame)
+        {
+            if (auto const text = std::get_if<std::string>(&frame))
+            {
+                if constexpr (has_callback<Callback, proprietary_sentence>)
+                {
+                    invoke_callback(callback, proprietary_sentence {{{text->data(), text->size()}, {}}});
+                }
+            } else
+            {
+                std::visit([&callback](auto const & f)
+                {
+                    deliver(callback, f);
+                }, std::get<any_sentence>(frame));
+            }
+        }
+    };
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <tuple>
+#include <memory>
+#include <type_traits>
+#include <sentence.h>
+#include <fields.h>
+#include <units.h>
+
+// What a machine calls with the decoded frames: either a type with static callback() overloads or a callable object
+// the machine stores and invokes directly, with its state (port id, output queue, statistics) at hand.
+
+namespace serial
+{
+    template <class CALLBACK, class FRAME, class = void>
+    struct has_static_callback : std::false_type {};
+
+    template <class CALLBACK, class FRAME>
+    struct has_static_callback<CALLBACK, FRAME, std::void_t<decltype(CALLBACK::callback(std::declval<FRAME const &>()))>> : std::true_type {};
+
+    template <class CALLBACK, class FRAME>
+    struct takes_frame : std::bool_constant<has_static_callback<CALLBACK, FRAME>::value || std::is_invocable_v<CALLBACK &, FRAME const &>> {};
+
+    template <class CALLBACK>
+    struct takes_frame<CALLBACK, void> : std::false_type {}; // an unknown sentence
+
+    template <class CALLBACK, class FRAME>
+    constexpr bool has_callback = takes_frame<CALLBACK, FRAME>::value;
+
+    template <class CALLBACK, class FRAME>
+    void invoke_callback(CALLBACK & callback, FRAME const & frame)
+    {
+        if constexpr (has_static_callback<CALLBACK, FRAME>::value)
+        {
+            CALLBACK::callback(frame);
+        } else
+        {
+            callback(frame);
+        }
+    }
+
+    // whether the callback gets the typed frames of a sentence: only if it does not take them as they are decoded, so that
+    // a generic callback gets every sentence once, untyped
+    template <class CALLBACK, class FRAME>
+    constexpr bool wants_typed = !has_callback<CALLBACK, FRAME> && has_callback<CALLBACK, typed_frame_t<FRAME>>;
+
+    // whether the callback takes the frames of a sentence as they are decoded or typed
+    template <class CALLBACK, class FRAME>
+    constexpr bool wants_frame = has_callback<CALLBACK, FRAME> || wants_typed<CALLBACK, FRAME>;
+
+    // converts to every rmc_subset and to nothing else
+    struct any_rmc_subset
+    {
+        template <uint16_t FIELDS>
+        operator rmc_subset<FIELDS>() const noexcept;
+    };
+
+    struct not_a_frame {};
+
+    // Whether the callback takes an rmc_subset, of whatever fields; a generic callback does not count. Only a machine
+    // with those fields in its traits decodes one, and the other front ends reject such a callback.
+    template <class CALLBACK>
+    constexpr bool takes_some_rmc_subset = has_callback<CALLBACK, any_rmc_subset> && !has_callback<CALLBACK, not_a_frame>;
+
+    // whether the callback takes the frames of a sentence, or the proprietary sentences as they are
+    template <class CALLBACK>
+    [[nodiscard]] constexpr bool registered(sentence_id id) noexcept
+    {
+        if (id == sentence_id::proprietary)
+        {
+            return has_callback<CALLBACK, proprietary_sentence>;
+        }
+        return visit_sentence(id, [](auto tag) { return wants_frame<CALLBACK, typename decltype(tag)::type>; });
+    }
+
+    // hands a frame to the callback in the one form it gets
+    template <class CALLBACK, class FRAME>
+    void deliver(CALLBACK & callback, FRAME const & frame)
+    {
+        if constexpr (has_callback<CALLBACK, FRAME>)
+        {
+            invoke_callback(callback, frame);
+        } else if constexpr (wants_typed<CALLBACK, FRAME>)
+        {
+            invoke_callback(callback, to_fix(frame));
+        }
+    }
+
+    // Decodes the fields of a sentence the callback takes, from past the sentence id up to the checksum, and hands the
+    // frame to sink for deliver(); the typed frame is decoded directly if the callback takes only that. Returns false
+    // if there is no such frame.
+    template <class CALLBACK, class IT, class SINK>
+    bool decode_sentence(sentence_id id, IT first, IT last, SINK && sink)
+    {
+        return visit_sentence(id, [first, last, &sink](auto tag)
+        {
+            using decoded_type = typename decltype(tag)::type;
+            if constexpr (wants_frame<CALLBACK, decoded_type>)
+            {
+                using frame_type = std::conditional_t<has_callback<CALLBACK, decoded_type>, decoded_type, typed_frame_t<decoded_type>>;
+                frame_type frame {};
+                if (minmea_parse(&frame, first, last))
+                {
+                    sink(frame);
+                    return true;
+                }
+            }
+            return false;
+        });
+    }
+
+    // A non-owning reference to a callable taking the FRAMES listed, so that machines feeding different sinks still share
+    // one type. The callable must outlive the reference.
+    template <class... FRAMES>
+    class callback_ref
+    {
+        void * object_;
+        std::tuple<void (*)(void *, FRAMES const &)...> calls_;
+
+    public:
+        template <class F, class = std::enable_if_t<!std::is_same_v<std::remove_cv_t<F>, callback_ref>>>
+        callback_ref(F & f) noexcept
+                : object_(const_cast<void *>(static_cast<void const *>(std::addressof(f))))
+                , calls_([](void * object, FRAMES const & frame) { (*static_cast<F *>(object))(frame); }...)
+        {}
+
+        template <class FRAME, class = std::enable_if_t<(std::is_same_v<FRAME, FRAMES> || ...)>>
+        void operator()(FRAME const & frame) const
+        {
+            std::get<void (*)(void *, FRAME const &)>(calls_)(object_, frame);
+        }
+    };
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <span.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+// The NMEA checksum: the XOR of the bytes between '$' and '*', written after the '*' as two hex digits. The bytes are
+// XORed a machine word at a time over contiguous memory and the digits are decoded with a table.
+
+namespace serial
+{
+    constexpr uint8_t invalid_hex_digit = 0xFF;
+
+    constexpr std::array<uint8_t, 256> hex_digit_values = []
+    {
+        std::array<uint8_t, 256> table {};
+        for (auto & value : table)
+        {
+            value = invalid_hex_digit;
+        }
+        for (uint8_t i = 0; i < 10; ++i)
+        {
+            table['0' + i] = i;
+        }
+        for (uint8_t i = 0; i < 6; ++i)
+        {
+            table['A' + i] = 10 + i;
+            table['a' + i] = 10 + i;
+        }
+        return table;
+    }();
+
+    // the value of a two digit hex number, or a value above 0xFF if either is not a hex digit
+    [[nodiscard]] constexpr unsigned hex_byte(char high, char low) noexcept
+    {
+        auto const h = hex_digit_values[static_cast<uint8_t>(high)];
+        auto const l = hex_digit_values[static_cast<uint8_t>(low)];
+        return ((h | l) > 0xF) ? 0x100u : (unsigned(h) << 4u) | l;
+    }
+
+    // two independent words per step, then the rest of the bytes down to single ones
+    [[nodiscard]] inline uint8_t xor_bytes(char const * data, size_t n) noexcept
+    {
+        uint64_t a = 0;
+        uint64_t b = 0;
+        size_t i = 0;
+        for (; i + 2 * sizeof(uint64_t) <= n; i += 2 * sizeof(uint64_t))
+        {
+            uint64_t x, y;
+            std::memcpy(&x, data + i, sizeof(x));
+            std::memcpy(&y, data + i + sizeof(x), sizeof(y));
+            a ^= x;
+            b ^= y;
+        }
+        a ^= b;
+        if (n - i >= sizeof(uint64_t))
+        {
+            std::memcpy(&b, data + i, sizeof(b));
+            a ^= b;
+            i += sizeof(uint64_t);
+        }
+        if (n - i >= sizeof(uint32_t))
+        {
+            uint32_t x;
+            std::memcpy(&x, data + i, sizeof(x));
+            a ^= x;
+            i += sizeof(uint32_t);
+        }
+        a ^= a >> 32u;
+        a ^= a >> 16u;
+        a ^= a >> 8u;
+        auto sum = static_cast<uint8_t>(a);
+        for (; i != n; ++i)
+        {
+            sum ^= static_cast<uint8_t>(data[i]);
+        }
+        return sum;
+    }
+
+    [[nodiscard]] inline uint8_t xor_bytes(ring_segments const & segments) noexcept
+    {
+        return xor_bytes(segments.first.data(), segments.first.size()) ^ xor_bytes(segments.second.data(), segments.second.size());
+    }
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#if __cplusplus < 202002L || !defined(__cpp_impl_coroutine)
+#error "coro.h needs C++20 coroutines"
+#endif
+
+#include <machine.h>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <optional>
+#include <utility>
+
+// A coroutine front end to the machine. A coroutine awaits the next frame; if the ring has none it suspends, and the
+// fill_data() call that brings one resumes it, so the parser plugs into an event loop with no queue in between. Frames
+// are handed over in place. The coroutine frames themselves can be put into an arena: the coroutines started on a thread
+// while a scoped frame_arena::use guard is alive there take their frames from it instead of the heap.
+
+namespace serial
+{
+    // receives the frames of the machine of an async_machine, one at a time
+    template <class FRAME>
+    struct frame_slot
+    {
+        std::optional<FRAME> * frame;
+
+        template <class F, class = std::enable_if_t<std::is_same_v<F, FRAME> || (std::is_same_v<FRAME, any_sentence> && std::is_constructible_v<FRAME, F const &>)>>
+        void operator()(F const & f) const
+        {
+            frame->emplace(f);
+        }
+    };
+
+    // FRAME is the frame type to await, any_sentence for all of them
+    template <size_t bs, class FRAME = minmea_sentence_rmc, class Traits = default_traits>
+    class async_machine
+    {
+        std::optional<FRAME> frame_;
+        machine<bs, frame_slot<FRAME>, Traits> machine_ {frame_slot<FRAME> {&frame_}};
+        std::coroutine_handle<> waiting_;
+
+        // runs the states up to the next frame or until the bytes run out
+        bool next() noexcept
+        {
+            while (!frame_ && machine_.parse());
+            return frame_.has_value();
+        }
+
+        class awaiter
+        {
+            async_machine & machine_;
+        public:
+            explicit awaiter(async_machine & machine) noexcept : machine_(machine) {}
+
+            bool await_ready() noexcept
+            {
+                return machine_.next();
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) noexcept
+            {
+                machine_.waiting_ = handle;
+            }
+
+            FRAME await_resume() noexcept
+            {
+                auto const frame = *machine_.frame_;
+                machine_.frame_.reset();
+                return frame;
+            }
+        };
+
+    public:
+        async_machine() = default;
+        async_machine(async_machine const &) = delete;
+        async_machine & operator=(async_machine const &) = delete;
+
+        // co_await for the next frame
+        [[nodiscard]] awaiter next_fix() noexcept
+        {
+            return awaiter(*this);
+        }
+
+        // fills the bytes in and resumes the coroutine waiting, if they complete a frame for it
+        void fill_data(char const * data, size_t n)
+        {
+            machine_.fill_data(data, n);
+            if (waiting_ && next())
+            {
+                std::exchange(waiting_, {}).resume();
+            }
+        }
+
+        [[nodiscard]] bool waiting() const noexcept
+        {
+            return static_cast<bool>(waiting_);
+        }
+
+        [[nodiscard]] machine<bs, frame_slot<FRAME>, Traits> const & get_machine() const noexcept
+        {
+            return machine_;
+        }
+    };
+
+    // Memory for coroutine frames, taken from a fixed buffer and given back all at once by reset(). The coroutines started
+    // on a thread while a frame_arena::use of it is alive there put their frames into it.
+    class frame_arena
+    {
+        std::byte * data_;
+        size_t size_;
+        size_t used_ = 0;
+
+        static inline thread_local frame_arena * current_ = nullptr;
+
+    public:
+        frame_arena(std::byte * data, size_t size) noexcept : data_(data), size_(size) {}
+        template <size_t N>
+        explicit frame_arena(std::byte (&data)[N]) noexcept : frame_arena(data, N) {}
+
+        frame_arena(frame_arena const &) = delete;
+        frame_arena & operator=(frame_arena const &) = delete;
+
+        class use
+        {
+            frame_arena * previous_;
+        public:
+            explicit use(frame_arena & arena) noexcept : previous_(std::exchange(current_, &arena)) {}
+            use(use const &) = delete;
+            use & operator=(use const &) = delete;
+            ~use()
+            {
+                current_ = previous_;
+            }
+        };
+
+        [[nodiscard]] static frame_arena * current() noexcept
+        {
+            return current_;
+        }
+
+        [[nodiscard]] void * allocate(size_t n)
+        {
+            auto const at = (used_ + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+            if (at + n > size_)
+            {
+                throw std::bad_alloc();
+            }
+            used_ = at + n;
+            return data_ + at;
+        }
+
+        void reset() noexcept
+        {
+            used_ = 0;
+        }
+
+        [[nodiscard]] size_t used() const noexcept
+        {
+            return used_;
+        }
+    };
+
+    // A coroutine that starts at once and runs on its own, e.g. a consumer awaiting frames in a loop. Its frame comes from
+    // the arena in use, from the heap if there is none, once per coroutine and not per frame awaited.
+    class fix_task
+    {
+    public:
+        struct promise_type
+        {
+            fix_task get_return_object() noexcept
+            {
+                return fix_task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_never initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_void() noexcept {}
+
+            void unhandled_exception() noexcept
+            {
+                std::terminate();
+            }
+
+            static void * operator new(size_t n)
+            {
+                auto const arena = frame_arena::current();
+                auto const p = arena ? arena->allocate(n + sizeof(bool)) : ::operator new(n + sizeof(bool));
+                *reinterpret_cast<bool *>(static_cast<char *>(p) + n) = arena != nullptr; // where it comes from, past the frame
+                return p;
+            }
+
+            // the arena gives its frames back with reset()
+            static void operator delete(void * p, size_t n) noexcept
+            {
+                if (!*reinterpret_cast<bool *>(static_cast<char *>(p) + n))
+                {
+                    ::operator delete(p);
+                }
+            }
+        };
+
+        fix_task(fix_task && other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+        fix_task(fix_task const &) = delete;
+        fix_task & operator=(fix_task const &) = delete;
+        fix_task & operator=(fix_task &&) = delete;
+
+        ~fix_task()
+        {
+            if (handle_)
+            {
+                handle_.destroy();
+            }
+        }
+
+        [[nodiscard]] bool done() const noexcept
+        {
+            return handle_.done();
+        }
+
+    private:
+        explicit fix_task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+        std::coroutine_handle<promise_type> handle_;
+    };
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <sentence.h>
+#include <tokenizer.h>
+#include <cstdint>
+#include <tuple>
+
+// RMC frames with only the fields asked for. The fields left out are skipped over as the scan looks for the next comma,
+// with no digits converted and no check of what they hold, and they take no room in the frame: every field is a base of
+// its own, empty when it is not asked for.
+
+namespace serial
+{
+    // the fields of RMC to or together into a mask
+    namespace rmc_field
+    {
+        constexpr uint16_t time = 1u << 0u;
+        constexpr uint16_t validity = 1u << 1u;
+        constexpr uint16_t latitude = 1u << 2u;  // with its hemisphere
+        constexpr uint16_t longitude = 1u << 3u; // with its hemisphere
+        constexpr uint16_t speed = 1u << 4u;
+        constexpr uint16_t course = 1u << 5u;
+        constexpr uint16_t date = 1u << 6u;
+        constexpr uint16_t variation = 1u << 7u; // with its direction
+        constexpr uint16_t all = 0xFFu;
+    }
+
+    namespace rmc_member
+    {
+        template <bool> struct time {};
+        template <> struct time<true> { minmea_time time; };
+        template <bool> struct validity {};
+        template <> struct validity<true> { bool valid; };
+        template <bool> struct latitude {};
+        template <> struct latitude<true> { minmea_float latitude; };
+        template <bool> struct longitude {};
+        template <> struct longitude<true> { minmea_float longitude; };
+        template <bool> struct speed {};
+        template <> struct speed<true> { minmea_float speed; };
+        template <bool> struct course {};
+        template <> struct course<true> { minmea_float course; };
+        template <bool> struct date {};
+        template <> struct date<true> { minmea_date date; };
+        template <bool> struct variation {};
+        template <> struct variation<true> { minmea_float variation; };
+    }
+
+    // the members of minmea_sentence_rmc the mask has, by the same names
+    template <uint16_t FIELDS>
+    struct rmc_subset : rmc_member::time<(FIELDS & rmc_field::time) != 0>,
+                        rmc_member::validity<(FIELDS & rmc_field::validity) != 0>,
+                        rmc_member::latitude<(FIELDS & rmc_field::latitude) != 0>,
+                        rmc_member::longitude<(FIELDS & rmc_field::longitude) != 0>,
+                        rmc_member::speed<(FIELDS & rmc_field::speed) != 0>,
+                        rmc_member::course<(FIELDS & rmc_field::course) != 0>,
+                        rmc_member::date<(FIELDS & rmc_field::date) != 0>,
+                        rmc_member::variation<(FIELDS & rmc_field::variation) != 0>
+    {
+        static constexpr uint16_t fields = FIELDS;
+    };
+
+    template <uint16_t FIELDS>
+    inline constexpr sentence_id sentence_id_of<rmc_subset<FIELDS>> = sentence_id::rmc;
+
+    namespace minmea_field
+    {
+        struct skipped // a field nobody asked for
+        {
+            using value_type = skipped;
+
+            template <typename RING_IT>
+            static bool decode(RING_IT, bool, skipped &) noexcept {
+                return true;
+            }
+        };
+    }
+
+    template <uint16_t FIELDS>
+    struct sentence_layout<rmc_subset<FIELDS>>
+    {
+        template <uint16_t FIELD, class DECODER>
+        using pick = std::conditional_t<(FIELDS & FIELD) != 0, DECODER, minmea_field::skipped>;
+
+        using schema = minmea_schema<pick<rmc_field::time, minmea_field::time>, pick<rmc_field::validity, minmea_field::character>,
+                                     pick<rmc_field::latitude, minmea_field::fixed>, pick<rmc_field::latitude, minmea_field::direction>,
+                                     pick<rmc_field::longitude, minmea_field::fixed>, pick<rmc_field::longitude, minmea_field::direction>,
+                                     pick<rmc_field::speed, minmea_field::fixed>, pick<rmc_field::course, minmea_field::fixed>,
+                                     pick<rmc_field::date, minmea_field::date>,
+                                     pick<rmc_field::variation, minmea_field::fixed>, pick<rmc_field::variation, minmea_field::direction>>;
+
+        struct extras {
+            char validity;
+            int latitude_direction;
+            int longitude_direction;
+            int variation_direction;
+            minmea_field::skipped none;
+        };
+
+        // the member of the frame or of the extras a field is decoded into, none if it is skipped
+        template <uint16_t FIELD, class TARGET>
+        static auto & target(TARGET & target, extras & e) noexcept {
+            if constexpr ((FIELDS & FIELD) != 0)
+                return target;
+            else
+                return e.none;
+        }
+
+        template <class FRAME>
+        static auto targets(FRAME & frame, extras & e) noexcept {
+            namespace f = rmc_field;
+            return std::tie(target<f::time>(member<f::time>(frame), e),
+                            target<f::validity>(e.validity, e),
+                            target<f::latitude>(member<f::latitude>(frame), e), target<f::latitude>(e.latitude_direction, e),
+                            target<f::longitude>(member<f::longitude>(frame), e), target<f::longitude>(e.longitude_direction, e),
+                            target<f::speed>(member<f::speed>(frame), e),
+                            target<f::course>(member<f::course>(frame), e),
+                            target<f::date>(member<f::date>(frame), e),
+                            target<f::variation>(member<f::variation>(frame), e), target<f::variation>(e.variation_direction, e));
+        }
+
+        template <class FRAME>
+        static bool finish(FRAME & frame, extras const & e) noexcept {
+            if constexpr ((FIELDS & rmc_field::validity) != 0)
+                frame.valid = (e.validity == 'A');
+            if constexpr ((FIELDS & rmc_field::latitude) != 0)
+                frame.latitude.value *= e.latitude_direction;
+            if constexpr ((FIELDS & rmc_field::longitude) != 0)
+                frame.longitude.value *= e.longitude_direction;
+            if constexpr ((FIELDS & rmc_field::variation) != 0)
+                frame.variation.value *= e.variation_direction;
+            return true;
+        }
+
+    private:
+        // the member of a field asked for, the frame itself (never decoded into) for one left out
+        template <uint16_t FIELD, class FRAME>
+        static auto & member(FRAME & frame) noexcept {
+            namespace f = rmc_field;
+            if constexpr ((FIELDS & FIELD) == 0)
+                return frame;
+            else if constexpr (FIELD == f::time)
+                return frame.time;
+            else if constexpr (FIELD == f::latitude)
+                return frame.latitude;
+            else if constexpr (FIELD == f::longitude)
+                return frame.longitude;
+            else if constexpr (FIELD == f::speed)
+                return frame.speed;
+            else if constexpr (FIELD == f::course)
+                return frame.course;
+            else if constexpr (FIELD == f::date)
+                return frame.date;
+            else
+                return frame.variation;
+        }
+    };
+
+    template <uint16_t FIELDS, typename RING_IT>
+    bool minmea_parse(rmc_subset<FIELDS> * frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_layout(frame, it, end); }
+}
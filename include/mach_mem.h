@@ -2,13 +2,13 @@
 
 namespace serial
 {
-    template <size_t, typename>
+    template <size_t, typename, typename>
     class machine;
 
     template <class M>
     class machine_memento
     {
-        template <size_t, typename>
+        template <size_t, typename, typename>
         friend class machine;
 
         typename M::const_iterator b;
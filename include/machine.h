@@ -2,9 +2,14 @@
 
 #include <ring_iter.h>
 #include <tokenizer.h>
+#include <sentence.h>
+#include <scanner.h>
+#include <callback.h>
 #include <mach_mem.h>
 #include <states.h>
-#include <functional>
+#include <traits.h>
+#include <algorithm>
+#include <utility>
 
 #ifdef _MSC_VER
 #pragma warning(disable : 4355)
@@ -14,17 +19,25 @@ namespace serial
 {
     using namespace funny_it;
 
-    using state_destructor_type = std::function<void(void*)>;
-    using state_ptr = std::unique_ptr<state, state_destructor_type>;
-
     template <size_t bs, class E = exception_unchecked_variant_type>
     using machine_implementation_type = ring_buffer_sequence<char, bs, E>;
 
-    template <size_t bs, class RMC_Callback>
-    class machine : private machine_implementation_type<bs>
+    // owns the bytes of a machine; being the first base it is alive before the ring is bound to it
+    template <size_t bs>
+    class machine_buffer
+    {
+    protected:
+        char buffer [bs] {};
+    };
+
+    // the stats, the profiler and the latency probe are bases so that the empty ones take no room
+    template <size_t bs, class Callback, class Traits = default_traits>
+    class machine : private machine_buffer<bs>, private machine_implementation_type<bs>,
+                    private Traits::stats_type, private Traits::profiler_type, private Traits::latency_type
     {
     private:
-        static char buffer [bs];
+        using buffer_class_type = machine_buffer<bs>;
+        using buffer_class_type::buffer;
         using parent_class_type = machine_implementation_type<bs>;
     public:
         using parent_class_type::align;
@@ -32,77 +45,299 @@ namespace serial
         using parent_class_type::distance;
         using parent_class_type::begin;
         using parent_class_type::end;
-        using parent_class_type::fill_data;
         using const_iterator = typename parent_class_type::const_iterator;
+        using traits_type = Traits;
+        using stats_type = typename Traits::stats_type;
+        using profiler_type = typename Traits::profiler_type;
+        using latency_type = typename Traits::latency_type;
     private:
         using class_type = machine;
         using parse_$_state_type = Parse$State<class_type>;
-        using parse_rmc_state_type = ParseRmcState<class_type>;
+        using parse_id_state_type = ParseIdState<class_type>;
         using parse_crlf_state_type = ParseCrlfState<class_type>;
         using parse_checksum_state_type = ParseChecksumState<class_type>;
 
+        static_assert(Traits::max_sentence_size + 3 <= bs, "the ring has to hold the longest sentence with its '$' and cr-lf");
+
         friend parse_$_state_type;
+        friend parse_id_state_type;
         friend parse_crlf_state_type;
         friend parse_checksum_state_type;
 
-        state_ptr const parse_$_state_;
-        state_ptr const parse_rmc_state_;
-        state_ptr const parse_crlf_state_;
-        state_ptr const parse_checksum_state_;
+        parse_$_state_type parse_$_state_ {*this};
+        parse_id_state_type parse_id_state_ {*this};
+        parse_crlf_state_type parse_crlf_state_ {*this};
+        parse_checksum_state_type parse_checksum_state_ {*this};
 
-    protected:
-        state* current_state {nullptr};
+        Callback callback_;
 
-        static_assert(sizeof(parse_$_state_type) <= sizeof(parse_$_state_type::storage));
-        static_assert(sizeof(parse_rmc_state_type) <= sizeof(parse_rmc_state_type::storage));
-        static_assert(sizeof(parse_crlf_state_type) <= sizeof(parse_crlf_state_type::storage));
-        static_assert(sizeof(parse_checksum_state_type) <= sizeof(parse_checksum_state_type::storage));
+    protected:
+        state_id current_state {state_id::parse_$};
 
     public:
-        machine() : parent_class_type(buffer)
-                , parse_$_state_(new(parse_$_state_type::storage)parse_$_state_type(*this), [](void * obj){static_cast<parse_$_state_type*>(obj)->~parse_$_state_type();})
-                , parse_rmc_state_(new(parse_rmc_state_type::storage)parse_rmc_state_type(*this), [](void * obj){static_cast<parse_rmc_state_type*>(obj)->~parse_rmc_state_type();})
-                , parse_crlf_state_(new(parse_crlf_state_type::storage)parse_crlf_state_type(*this), [](void * obj){static_cast<parse_crlf_state_type*>(obj)->~parse_crlf_state_type();})
-                , parse_checksum_state_(new(parse_checksum_state_type::storage)parse_checksum_state_type(*this), [](void * obj){static_cast<parse_checksum_state_type*>(obj)->~parse_checksum_state_type();})
+        explicit machine(Callback callback = Callback {}) : parent_class_type(buffer), callback_(std::move(callback)) {}
+
+        // States are bound to the machine they live in, so moving re-creates them here and takes over the other's progress.
+        machine(machine && other) noexcept : machine(std::move(other.callback_))
+        {
+            relocate(other);
+        }
+
+        machine & operator=(machine && other) noexcept
         {
-            current_state = parse_$_state_.get();
+            if (this != &other)
+            {
+                callback_ = std::move(other.callback_);
+                relocate(other);
+            }
+            return *this;
         }
+
+        machine(machine const &) = delete;
+        machine & operator=(machine const &) = delete;
         virtual ~machine() = default;
 
-        [[nodiscard]] constexpr bool parse() const noexcept
+        bool parse() noexcept
+        {
+            if constexpr (profiler_type::enabled)
+            {
+                auto const state = current_state;
+                auto const start = cycle_count();
+                auto const more = run_state();
+                profiler().on_stage(state, cycle_count() - start);
+                return more;
+            } else
+            {
+                return run_state();
+            }
+        }
+
+        // Takes all of the bytes, as the overflow policy of the traits says if they do not fit. With the blocking
+        // policy the states run, and the callback is called, from within.
+        void fill_data(char const * data, size_t n) noexcept
+        {
+            counters().on_consumed(n);
+            fill_ring(data, n);
+        }
+
+        // takes as many of the bytes as fit and tells how many that is, never dropping any
+        size_t try_fill(char const * data, size_t n) noexcept
         {
-            return current_state->parse();
+            auto const accepted = std::min(n, available());
+            counters().on_consumed(accepted);
+            parent_class_type::fill_data(data, accepted);
+            return accepted;
         }
 
-        [[nodiscard]] constexpr state_ptr const & get_parse_$_state() const noexcept
+        // the bytes that can be filled in without overwriting unparsed ones or a sentence in flight
+        [[nodiscard]] size_t available() const noexcept
         {
-            return parse_$_state_;
+            return bs - in_flight();
         }
 
-        [[nodiscard]] constexpr state_ptr const & get_parse_rmc_state() const noexcept
+        // runs the states until the input runs out
+        void parse_all() noexcept
         {
-            return parse_rmc_state_;
+            while (parse());
         }
 
-        [[nodiscard]] constexpr state_ptr const & get_parse_crlf_state() const noexcept
+        // Parses a chunk straight from the caller's memory: whole sentences are decoded in place and only a trailing
+        // partial one is copied into the ring, to be completed by the next chunks. Sentences go to the callback
+        // directly, bypassing process().
+        void parse(char const * data, size_t n) noexcept
         {
-            return parse_crlf_state_;
+            counters().on_consumed(n);
+            auto const last = data + n;
+            if (!idle())
+            {
+                // let the ring finish the sentence in flight first
+                auto const lf = std::find(data, last, '\x0A');
+                auto const tail = (lf == last) ? last : lf + 1;
+                fill_ring(data, tail - data);
+                while (parse());
+                data = tail;
+                if (!idle())
+                {
+                    fill_ring(data, last - data);
+                    while (parse());
+                    return;
+                }
+            }
+
+            while (data != last)
+            {
+                auto const sentence = next_sentence(data, last, registered, Traits::max_sentence_size);
+                if (sentence.status == sentence_status::none)
+                {
+                    counters().on_garbage(last - data);
+                    return;
+                }
+                if (sentence.status == sentence_status::partial)
+                {
+                    // the ring counts the sentence when it frames it, and stamps its '$' as it takes the head now
+                    counters().on_garbage(sentence.next - data);
+                    fill_ring(sentence.next, last - sentence.next);
+                    while (parse());
+                    return;
+                }
+                probe().on_dollar(); // the whole sentence is in this chunk, its '$' is first seen now
+                counters().on_garbage((sentence.begin - 1) - data);
+                counters().on_sentence(sentence.id);
+                switch (sentence.status)
+                {
+                    case sentence_status::accepted:
+                        probe().on_crlf();
+                        if (sentence.id == sentence_id::proprietary)
+                            pass_through(ring_segments {{sentence.begin, size_t(sentence.end - sentence.begin)}, {}});
+                        else
+                            decode(sentence.id, sentence.begin + 6, sentence.end);
+                        break;
+                    case sentence_status::oversize: counters().on_resync(); break;
+                    case sentence_status::malformed: counters().on_malformed(); break;
+                    case sentence_status::checksum_failed: counters().on_checksum_failed(); break;
+                    default: break;
+                }
+                data = sentence.next;
+            }
         }
 
-        [[nodiscard]] constexpr state_ptr const & get_parse_checksum_state() const noexcept
+        // the unparsed bytes as the (at most two) contiguous pieces of the buffer they occupy
+        [[nodiscard]] ring_segments segments() const noexcept
         {
-            return parse_checksum_state_;
+            return segments(begin(), size());
         }
 
-        constexpr void set_state (state_ptr const & state ) noexcept
+        [[nodiscard]] bool idle() const noexcept
         {
-            current_state->cleanup();
-            current_state = state.get();
+            return (current_state == state_id::parse_$) && (size() == 0);
+        }
+
+        constexpr void set_state (state_id next) noexcept
+        {
+            switch (current_state)
+            {
+                case state_id::parse_$: parse_$_state_.cleanup(); break;
+                case state_id::parse_id: parse_id_state_.cleanup(); break;
+                case state_id::parse_crlf: parse_crlf_state_.cleanup(); break;
+                case state_id::parse_checksum: parse_checksum_state_.cleanup(); break;
+            }
+            current_state = next;
         }
 
     private:
+        bool run_state() noexcept
+        {
+            switch (current_state)
+            {
+                case state_id::parse_$: return parse_$_state_.parse();
+                case state_id::parse_id: return parse_id_state_.parse();
+                case state_id::parse_crlf: return parse_crlf_state_.parse();
+                case state_id::parse_checksum: return parse_checksum_state_.parse();
+            }
+            return false;
+        }
+
+        constexpr stats_type & counters() noexcept
+        {
+            return *this;
+        }
+
+        constexpr profiler_type & profiler() noexcept
+        {
+            return *this;
+        }
+
+        constexpr latency_type & probe() noexcept
+        {
+            return *this;
+        }
+
+        // the bytes the ring holds, together with the head of a sentence in flight
+        [[nodiscard]] size_t in_flight() const noexcept
+        {
+            return (current_state == state_id::parse_$) ? size() : distance(start_iterator, end());
+        }
+
+        void fill_ring(char const * data, size_t n) noexcept
+        {
+            if (n > available())
+            {
+                counters().on_ring_full();
+                if constexpr (Traits::overflow == overflow_policy::drop_newest)
+                {
+                    counters().on_dropped(n - available());
+                    n = available();
+                } else if constexpr (Traits::overflow == overflow_policy::block)
+                {
+                    while (n > available())
+                    {
+                        auto const part = available();
+                        parent_class_type::fill_data(data, part);
+                        data += part;
+                        n -= part;
+                        while (parse());
+                        if (!available())
+                        {
+                            break; // a sentence in flight takes the whole ring
+                        }
+                    }
+                    make_room(data, n);
+                } else
+                {
+                    make_room(data, n);
+                }
+            }
+            parent_class_type::fill_data(data, n);
+        }
+
+        // drops the oldest bytes, together with a sentence in flight they belong to, to make room for n more
+        void make_room(char const * & data, size_t & n) noexcept
+        {
+            if (n <= available())
+            {
+                return;
+            }
+            counters().on_dropped(in_flight() + n - bs);
+            if (n >= bs)
+            {
+                data += n - bs;
+                n = bs;
+                align();
+                drop_sentence();
+                return;
+            }
+            auto excess = in_flight() + n - bs;
+            if (current_state != state_id::parse_$)
+            {
+                // the sentence loses its head, the bytes after it are searched again
+                excess -= std::min(excess, distance(start_iterator, begin()));
+                drop_sentence();
+            }
+            align(begin() + excess);
+        }
+
+        // gives up the sentence in flight where the ring is now; in parse_checksum the ring is already past its cr-lf,
+        // and the cleanup would roll it back to where the previous sentence was checked
+        void drop_sentence() noexcept
+        {
+            if (current_state == state_id::parse_checksum)
+            {
+                current_state = state_id::parse_$;
+            } else if (current_state != state_id::parse_$)
+            {
+                set_state(state_id::parse_$);
+            }
+        }
+
         const_iterator start_iterator = begin();
         const_iterator stop_iterator = begin();
+        sentence_id sentence_ = sentence_id::unknown;
+
+        constexpr void save_id(sentence_id id) noexcept
+        {
+            sentence_ = id;
+        }
+
         constexpr void save_start(const_iterator it) noexcept
         {
             start_iterator = it;
@@ -128,6 +363,46 @@ namespace serial
             parent_class_type::unchecked_reset(mem.b, mem.e);
         }
 
+        [[nodiscard]] ring_segments segments (const_iterator from, size_t count) const noexcept
+        {
+            if (!count)
+            {
+                return {};
+            }
+            char const * const first = &*from;
+            auto const first_size = std::min<size_t>(count, (buffer + bs) - first);
+            return {{first, first_size}, {buffer, count - first_size}};
+        }
+
+        // copies the unparsed bytes of other, together with the head of a sentence in flight, to own buffer
+        void relocate (machine const & other) noexcept
+        {
+            auto const state = other.current_state;
+            bool const in_flight = (state != state_id::parse_$);
+            auto const from = in_flight ? other.start_iterator : other.begin();
+            auto const head = other.distance(from, other.begin());
+            auto const count = head + other.size();
+
+            parent_class_type::align();
+            auto const origin = end();
+            if (count)
+            {
+                auto const pieces = other.segments(from, count);
+                parent_class_type::fill_data(pieces.first.data(), pieces.first.size());
+                parent_class_type::fill_data(pieces.second.data(), pieces.second.size());
+            }
+            parent_class_type::align(origin + head);
+
+            start_iterator = origin;
+            sentence_ = other.sentence_;
+            stop_iterator = (state == state_id::parse_checksum) ? origin + other.distance(from, other.stop_iterator) : origin;
+            parse_crlf_state_.adopt(other.parse_crlf_state_);
+            current_state = state;
+            counters() = other.stats();
+            profiler() = other.profile();
+            probe() = other.latency();
+        }
+
     public:
         [[nodiscard]] constexpr const_iterator get_start() const noexcept
         {
@@ -139,16 +414,113 @@ namespace serial
             return stop_iterator;
         }
 
+        // the sentence types the callback takes
+        template <class FRAME>
+        static constexpr bool handles = has_callback<Callback, FRAME>;
+
+        // the RMC frame with the fields of the traits only, decoded if they leave some out and the callback takes it
+        using rmc_subset_type = rmc_subset<Traits::rmc_fields>;
+        static constexpr bool takes_rmc_subset = (Traits::rmc_fields != rmc_field::all) && handles<rmc_subset_type>;
+        static_assert(takes_rmc_subset || !takes_some_rmc_subset<Callback>,
+                      "the callback takes an rmc_subset of other fields than the rmc_fields of the traits");
+
+        [[nodiscard]] static constexpr bool registered (sentence_id id) noexcept
+        {
+            return serial::registered<Callback>(id) || (takes_rmc_subset && (id == sentence_id::rmc));
+        }
+
+        [[nodiscard]] constexpr Callback & get_callback() noexcept
+        {
+            return callback_;
+        }
+
+        [[nodiscard]] constexpr sentence_id get_id() const noexcept
+        {
+            return sentence_;
+        }
+
+        [[nodiscard]] constexpr stats_type const & stats() const noexcept
+        {
+            return *this;
+        }
+
+        [[nodiscard]] constexpr profiler_type const & profile() const noexcept
+        {
+            return *this;
+        }
+
+        [[nodiscard]] constexpr latency_type const & latency() const noexcept
+        {
+            return *this;
+        }
+
         virtual void process()
         {
-            minmea_sentence_rmc frame {};
-            if (minmea_parse_rmc(&frame, begin()+6, end()))
+            if (sentence_ == sentence_id::proprietary)
+            {
+                pass_through(segments(begin(), size()));
+            } else
             {
-                RMC_Callback::callback(frame);
+                decode(sentence_, begin()+6, end());
+            }
+        }
+
+    protected:
+        void pass_through(ring_segments text) noexcept
+        {
+            if constexpr (has_callback<Callback, proprietary_sentence>)
+            {
+                probe().on_callback(sentence_id::proprietary);
+                invoke_callback(callback_, proprietary_sentence {text});
+            }
+        }
+
+        template <class IT>
+        void decode(sentence_id id, IT first, IT last) noexcept
+        {
+            // a callback taking more than one form of the sentence gets each form decoded once, the latency stamped
+            // before the first of them, and a field error counted once if any form does not decode
+            bool stamped = false;
+            auto const sink = [this, id, &stamped](auto const & frame)
+            {
+                if (!std::exchange(stamped, true))
+                {
+                    probe().on_callback(id);
+                }
+                deliver(callback_, frame);
+            };
+            bool decoded = true;
+            if constexpr (takes_rmc_subset)
+            {
+                if (id == sentence_id::rmc)
+                {
+                    rmc_subset_type frame {};
+                    decoded = minmea_parse(&frame, first, last);
+                    if (decoded)
+                    {
+                        sink(frame);
+                    }
+                    if constexpr (!wants_frame<Callback, minmea_sentence_rmc>)
+                    {
+                        if (!decoded)
+                        {
+                            counters().on_field_error();
+                        }
+                        return;
+                    }
+                }
+            }
+            if (!decode_sentence<Callback>(id, first, last, sink) || !decoded)
+            {
+                counters().on_field_error();
             }
         }
     };
-    template <size_t bs, class RMC_Callback>
-    char machine<bs, RMC_Callback>::buffer[bs] = {};
-}
 
+    // lets the callback type be deduced, e.g. from a lambda
+    template <size_t bs, class Traits = default_traits, class Callback>
+    [[nodiscard]] machine<bs, std::decay_t<Callback>, Traits> make_machine(Callback && callback)
+    {
+        return machine<bs, std::decay_t<Callback>, Traits>(std::forward<Callback>(callback));
+    }
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <sentence.h>
+#include <fields.h>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Reading of recorded files with no copies: the file is mapped for sequential access and the sentences are framed and
+// decoded lazily, straight from the mapped pages, as the range of frames is walked.
+
+namespace serial
+{
+    // Walks the frames of one sentence type or an rmc_subset, or of all of them with any_sentence, over contiguous memory.
+    // A trailing sentence with no CR-LF is not decoded.
+    template <class FRAME>
+    class frame_iterator
+    {
+        static constexpr bool any = std::is_same_v<FRAME, any_sentence>;
+        static_assert(any || (sentence_id_of<FRAME> != sentence_id::unknown), "not a frame of a known sentence");
+
+        char const * it_ {nullptr}; // past the current frame, nullptr at the end
+        char const * last_ {nullptr};
+        FRAME frame_ {};
+
+        [[nodiscard]] static constexpr bool wanted(sentence_id id) noexcept
+        {
+            return any ? (id != sentence_id::unknown) && (id != sentence_id::proprietary) : (id == sentence_id_of<FRAME>);
+        }
+
+        void advance() noexcept
+        {
+            while (it_ != last_)
+            {
+                auto const sentence = next_sentence(it_, last_, wanted);
+                if (sentence.status == sentence_status::partial)
+                {
+                    break;
+                }
+                it_ = sentence.next;
+                if ((sentence.status == sentence_status::accepted) && decode(sentence))
+                {
+                    return;
+                }
+            }
+            it_ = nullptr;
+        }
+
+        bool decode(flat_sentence const & sentence) noexcept
+        {
+            if constexpr (any)
+            {
+                return visit_sentence(sentence.id, [this, &sentence](auto tag)
+                {
+                    using frame_type = typename decltype(tag)::type;
+                    if constexpr (!std::is_void_v<frame_type>)
+                    {
+                        frame_type frame {};
+                        if (minmea_parse(&frame, sentence.begin + 6, sentence.end))
+                        {
+                            frame_ = frame;
+                            return true;
+                        }
+                    }
+                    return false;
+                });
+            } else
+            {
+                frame_ = FRAME {};
+                return minmea_parse(&frame_, sentence.begin + 6, sentence.end);
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FRAME;
+        using difference_type = std::ptrdiff_t;
+        using pointer = FRAME const *;
+        using reference = FRAME const &;
+
+        frame_iterator() noexcept = default;
+
+        frame_iterator(char const * first, char const * last) noexcept : it_(first), last_(last)
+        {
+            advance();
+        }
+
+        reference operator*() const noexcept
+        {
+            return frame_;
+        }
+
+        pointer operator->() const noexcept
+        {
+            return &frame_;
+        }
+
+        frame_iterator & operator++() noexcept
+        {
+            advance();
+            return *this;
+        }
+
+        frame_iterator operator++(int) noexcept
+        {
+            auto const copy = *this;
+            advance();
+            return copy;
+        }
+
+        friend bool operator==(frame_iterator const & a, frame_iterator const & b) noexcept
+        {
+            return a.it_ == b.it_;
+        }
+
+        friend bool operator!=(frame_iterator const & a, frame_iterator const & b) noexcept
+        {
+            return a.it_ != b.it_;
+        }
+    };
+
+    template <class FRAME>
+    class frame_range
+    {
+        char const * first_;
+        char const * last_;
+    public:
+        constexpr frame_range(char const * first, char const * last) noexcept : first_(first), last_(last) {}
+
+        [[nodiscard]] frame_iterator<FRAME> begin() const noexcept
+        {
+            return {first_, last_};
+        }
+
+        [[nodiscard]] frame_iterator<FRAME> end() const noexcept
+        {
+            return {};
+        }
+    };
+
+    // A read-only mapping of a whole file. The ranges it gives are valid for as long as it lives.
+    class mapped_log
+    {
+        char const * data_ {nullptr};
+        size_t size_ {0};
+        bool open_ {false};
+
+    public:
+        explicit mapped_log(char const * path) noexcept
+        {
+            auto const fd = ::open(path, O_RDONLY);
+            if (fd < 0)
+            {
+                return;
+            }
+            struct stat st {};
+            if (::fstat(fd, &st) == 0)
+            {
+                size_ = static_cast<size_t>(st.st_size);
+                if (size_ == 0)
+                {
+                    open_ = true;
+                } else
+                {
+                    auto const pages = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (pages != MAP_FAILED)
+                    {
+                        ::madvise(pages, size_, MADV_SEQUENTIAL);
+                        data_ = static_cast<char const *>(pages);
+                        open_ = true;
+                    } else
+                    {
+                        size_ = 0;
+                    }
+                }
+            }
+            ::close(fd); // the mapping stays
+        }
+
+        mapped_log(mapped_log && other) noexcept
+                : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)), open_(std::exchange(other.open_, false))
+        {}
+
+        mapped_log & operator=(mapped_log && other) noexcept
+        {
+            if (this != &other)
+            {
+                unmap();
+                data_ = std::exchange(other.data_, nullptr);
+                size_ = std::exchange(other.size_, 0);
+                open_ = std::exchange(other.open_, false);
+            }
+            return *this;
+        }
+
+        mapped_log(mapped_log const &) = delete;
+        mapped_log & operator=(mapped_log const &) = delete;
+
+        ~mapped_log()
+        {
+            unmap();
+        }
+
+        [[nodiscard]] bool is_open() const noexcept
+        {
+            return open_;
+        }
+
+        [[nodiscard]] char const * data() const noexcept
+        {
+            return data_;
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return size_;
+        }
+
+        // the decoded frames of a sentence type, or of every known one with any_sentence
+        template <class FRAME = minmea_sentence_rmc>
+        [[nodiscard]] frame_range<FRAME> frames() const noexcept
+        {
+            return {data_, data_ + size_};
+        }
+
+    private:
+        void unmap() noexcept
+        {
+            if (data_)
+            {
+                ::munmap(const_cast<char *>(data_), size_);
+            }
+        }
+    };
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <spsc.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Many ports parsed by a fixed set of threads. Every port has its own machine fed by the thread submitting its chunks;
+// a port with bytes to parse is queued, once, with the thread it belongs to, which parses one ring of it at a time and
+// queues it again if there is more. Threads with nothing queued steal ports from the others, so a burst on one port keeps
+// one thread busy at most and the sentences of every port still reach its callback in order.
+
+namespace serial
+{
+    template <size_t bs, class Callback, class Traits = default_traits>
+    class parser_pool
+    {
+        struct port
+        {
+            spsc_machine<bs, Callback, Traits> machine;
+            std::atomic<bool> queued {false}; // with some thread or being parsed
+
+            explicit port(Callback callback) : machine(std::move(callback)) {}
+        };
+
+        struct alignas(cache_line_size) thread_queue
+        {
+            std::mutex mutex;
+            std::deque<size_t> ports;
+        };
+
+        std::vector<std::unique_ptr<port>> ports_;
+        std::unique_ptr<thread_queue[]> queues_;
+        unsigned const thread_count_;
+        std::vector<std::thread> threads_;
+
+        std::mutex idle_mutex_;
+        std::condition_variable wake_;
+        std::condition_variable drained_;
+        std::atomic<size_t> queued_ {0};  // ports in the queues
+        std::atomic<size_t> pending_ {0}; // ports queued or being parsed
+        bool stop_ = false;
+
+    public:
+        // make_callback(port) gives the callback of a port
+        template <class MAKE_CALLBACK>
+        parser_pool(size_t ports, unsigned threads, MAKE_CALLBACK make_callback)
+                : queues_(new thread_queue[std::max(threads, 1u)]), thread_count_(std::max(threads, 1u))
+        {
+            ports_.reserve(ports);
+            for (size_t i = 0; i < ports; ++i)
+            {
+                ports_.push_back(std::make_unique<port>(make_callback(i)));
+            }
+            for (unsigned i = 0; i < thread_count_; ++i)
+            {
+                threads_.emplace_back([this, i] { work(i); });
+            }
+        }
+
+        explicit parser_pool(size_t ports, unsigned threads = std::thread::hardware_concurrency())
+                : parser_pool(ports, threads, [](size_t) { return Callback {}; })
+        {}
+
+        parser_pool(parser_pool const &) = delete;
+        parser_pool & operator=(parser_pool const &) = delete;
+
+        // parses what is submitted before stopping the threads
+        ~parser_pool()
+        {
+            drain();
+            {
+                std::lock_guard<std::mutex> lock(idle_mutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto & thread : threads_)
+            {
+                thread.join();
+            }
+        }
+
+        // Hands a chunk of a port over to be parsed; the chunks of one port must come from one thread at a time.
+        // The overflow policy of the traits applies if the ring of the port is full.
+        void submit(size_t port, char const * data, size_t n)
+        {
+            ports_[port]->machine.fill_data(data, n);
+            schedule(port);
+        }
+
+        // waits until everything submitted so far is parsed
+        void drain()
+        {
+            std::unique_lock<std::mutex> lock(idle_mutex_);
+            drained_.wait(lock, [this] { return pending_.load() == 0; });
+        }
+
+        [[nodiscard]] size_t ports() const noexcept
+        {
+            return ports_.size();
+        }
+
+        [[nodiscard]] spsc_machine<bs, Callback, Traits> const & get_port(size_t port) const noexcept
+        {
+            return ports_[port]->machine;
+        }
+
+    private:
+        void schedule(size_t p)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst); // the bytes filled in are seen by whoever clears queued
+            if (ports_[p]->queued.exchange(true))
+            {
+                return;
+            }
+            ++pending_;
+            {
+                auto & queue = queues_[p % thread_count_];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.ports.push_back(p);
+            }
+            {
+                std::lock_guard<std::mutex> lock(idle_mutex_);
+                ++queued_;
+            }
+            wake_.notify_one();
+        }
+
+        // the oldest port of own queue, else the newest of another one
+        bool take(unsigned self, size_t & p)
+        {
+            for (unsigned i = 0; i < thread_count_; ++i)
+            {
+                auto & queue = queues_[(self + i) % thread_count_];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (!queue.ports.empty())
+                {
+                    if (i == 0)
+                    {
+                        p = queue.ports.front();
+                        queue.ports.pop_front();
+                    } else
+                    {
+                        p = queue.ports.back();
+                        queue.ports.pop_back();
+                    }
+                    --queued_;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void work(unsigned self)
+        {
+            for (;;)
+            {
+                size_t p;
+                if (take(self, p))
+                {
+                    run(p);
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(idle_mutex_);
+                wake_.wait(lock, [this] { return stop_ || queued_.load() != 0; });
+                if (stop_)
+                {
+                    return;
+                }
+            }
+        }
+
+        void run(size_t p)
+        {
+            auto & port = *ports_[p];
+            port.machine.parse();
+            port.queued.store(false);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!port.machine.empty())
+            {
+                schedule(p); // to the back of the queue, behind the other ports
+            }
+            if (--pending_ == 0)
+            {
+                std::lock_guard<std::mutex> lock(idle_mutex_);
+                drained_.notify_all();
+            }
+        }
+    };
+}
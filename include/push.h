@@ -0,0 +1,567 @@
+#pragma once
+
+#include <callback.h>
+#include <checksum.h>
+#include <traits.h>
+#include <units.h>
+#include <cstring>
+#include <tuple>
+#include <utility>
+#include <variant>
+
+// A decoder that never looks at a byte twice. The ring machine searches a sentence for its CR-LF, then runs over it
+// again for the checksum and once more to decode the fields, and a sentence trickling in a few bytes at a time has its
+// tail searched on every call. Here every byte pushed is taken into the running checksum and into the field it belongs
+// to as it comes; the field index, the partial values and the checksum carry over from one push to the next, so the cost
+// of a sentence is the same however it is chunked.
+
+namespace serial
+{
+    // the minmea_isfield() of the "C" locale, with no call
+    [[nodiscard]] constexpr bool field_char(char c) noexcept
+    {
+        return (c >= ' ') && (c <= '~') && (c != ',') && (c != '*');
+    }
+
+    // The field decoders taking a field a character at a time: push() is called with each of its characters, finish()
+    // then gives the value decode() would give for the whole field, or false.
+    template <class FIELD>
+    struct field_accumulator;
+
+    template <>
+    struct field_accumulator<minmea_field::character>
+    {
+        char first = '\0';
+
+        void push(char c) noexcept {
+            if (!first)
+                first = c;
+        }
+
+        bool finish(char & value) const noexcept {
+            value = first;
+            return true;
+        }
+    };
+
+    template <>
+    struct field_accumulator<minmea_field::direction>
+    {
+        char first = '\0';
+
+        void push(char c) noexcept {
+            if (!first)
+                first = c;
+        }
+
+        bool finish(int & value) const noexcept {
+            switch (first) {
+                case '\0': value = 0; return true;
+                case 'N':
+                case 'E': value = 1; return true;
+                case 'S':
+                case 'W': value = -1; return true;
+                default: return false;
+            }
+        }
+    };
+
+    template <>
+    struct field_accumulator<minmea_field::fixed>
+    {
+        int_least32_t value = -1;
+        int_least32_t scale = 0;
+        int_least8_t sign = 0;
+        bool done = false; // the precision is truncated, the rest of the field is skipped
+        bool bad = false;
+
+        void push(char c) noexcept {
+            if (done || bad)
+                return;
+            if (c == '+' && !sign && value == -1) {
+                sign = 1;
+            } else if (c == '-' && !sign && value == -1) {
+                sign = -1;
+            } else if (c >= '0' && c <= '9') {
+                int const digit = c - '0';
+                if (value == -1)
+                    value = 0;
+                if (value > (INT_LEAST32_MAX - digit) / 10) {
+                    done = (scale != 0);
+                    bad = !done;
+                    return;
+                }
+                value = (10 * value) + digit;
+                if (scale)
+                    scale *= 10;
+            } else if (c == '.' && scale == 0) {
+                scale = 1;
+            } else if (c == ' ') {
+                bad = (sign != 0 || value != -1 || scale != 0);
+            } else {
+                bad = true;
+            }
+        }
+
+        bool finish(minmea_float & result) const noexcept {
+            if (bad || ((sign || scale) && value == -1))
+                return false;
+            if (value == -1)
+                result = minmea_float {0, 0};
+            else
+                result = minmea_float {sign ? value * sign : value, scale ? scale : 1};
+            return true;
+        }
+    };
+
+    template <>
+    struct field_accumulator<minmea_field::integer>
+    {
+        long value = 0;
+        int_least8_t sign = 1;
+        uint8_t phase = 0; // spaces, sign, digits
+        bool any = false;
+        bool bad = false;
+
+        void push(char c) noexcept {
+            any = true;
+            if (bad)
+                return;
+            if (c >= '0' && c <= '9' && value <= INT_LEAST32_MAX) {
+                phase = 2;
+                value = (10 * value) + (c - '0');
+            } else if (phase == 0 && c == ' ') {
+            } else if (phase == 0 && (c == '+' || c == '-')) {
+                sign = (c == '-') ? -1 : 1;
+                phase = 1;
+            } else {
+                bad = true;
+            }
+        }
+
+        bool finish(int & result) const noexcept {
+            result = 0;
+            if (bad || (any && phase != 2))
+                return false;
+            result = static_cast<int>(sign * value);
+            return true;
+        }
+    };
+
+    template <>
+    struct field_accumulator<minmea_field::date>
+    {
+        int digits[6] {};
+        uint8_t count = 0;
+        bool bad = false;
+
+        void push(char c) noexcept {
+            if (count < 6) {
+                bad |= !(c >= '0' && c <= '9');
+                digits[count++] = c - '0';
+            }
+        }
+
+        bool finish(minmea_date & date) const noexcept {
+            date = minmea_date {-1, -1, -1};
+            if (count == 0)
+                return true;
+            if (bad || count < 6)
+                return false;
+            date = minmea_date {digits[0] * 10 + digits[1], digits[2] * 10 + digits[3], digits[4] * 10 + digits[5]};
+            return true;
+        }
+    };
+
+    template <>
+    struct field_accumulator<minmea_field::time>
+    {
+        int digits[6] {};
+        uint32_t fraction = 0;
+        uint32_t scale = 1000000LU;
+        uint8_t count = 0;
+        bool fractional = false;
+        bool done = false;
+        bool bad = false;
+
+        void push(char c) noexcept {
+            if (count < 6) {
+                bad |= !(c >= '0' && c <= '9');
+                digits[count++] = c - '0';
+            } else if (!fractional && !done) {
+                fractional = (c == '.');
+                done = !fractional;
+            } else if (fractional && !done) {
+                if (c >= '0' && c <= '9' && scale > 1) {
+                    fraction = (fraction * 10) + (c - '0');
+                    scale /= 10;
+                } else {
+                    done = true;
+                }
+            }
+        }
+
+        bool finish(minmea_time & time) const noexcept {
+            time = minmea_time {-1, -1, -1, -1};
+            if (count == 0)
+                return true;
+            if (bad || count < 6)
+                return false;
+            time = minmea_time {digits[0] * 10 + digits[1], digits[2] * 10 + digits[3], digits[4] * 10 + digits[5],
+                                fractional ? static_cast<int>(fraction * scale) : 0};
+            return true;
+        }
+    };
+
+    // the converting decoders of units.h
+    template <class FIELD, class VALUE, VALUE (*CONVERT)(minmea_float)>
+    struct converting_accumulator : field_accumulator<minmea_field::fixed>
+    {
+        bool finish(VALUE & value) const noexcept {
+            minmea_float f;
+            if (!field_accumulator<minmea_field::fixed>::finish(f))
+                return false;
+            value = CONVERT(f);
+            return true;
+        }
+    };
+
+    inline float to_float(minmea_float f) noexcept
+    {
+        return static_cast<float>(to_double(f));
+    }
+
+    template <>
+    struct field_accumulator<minmea_field::degrees> : converting_accumulator<minmea_field::degrees, double, to_degrees> {};
+    template <>
+    struct field_accumulator<minmea_field::knots> : converting_accumulator<minmea_field::knots, float, knots_to_mps> {};
+    template <>
+    struct field_accumulator<minmea_field::real> : converting_accumulator<minmea_field::real, float, to_float> {};
+
+    // the fields of a sentence being decoded, with its frame
+    template <class FRAME, class SCHEMA = typename sentence_layout<FRAME>::schema>
+    class partial_frame;
+
+    template <class FRAME, class... FIELDS>
+    class partial_frame<FRAME, minmea_schema<FIELDS...>>
+    {
+        using layout = sentence_layout<FRAME>;
+        using feeder = char const * (*)(partial_frame &, char const *, char const *, uint8_t &) noexcept;
+
+        std::tuple<field_accumulator<FIELDS>...> fields_;
+
+        // takes the characters of a field up to the end of the field or of the bytes
+        template <class ACCUMULATOR>
+        static char const * take(ACCUMULATOR * accumulator, char const * it, char const * last, uint8_t & sum) noexcept
+        {
+            for (; (it != last) && field_char(*it) && (*it != '$'); ++it)
+            {
+                sum ^= uint8_t(*it);
+                if (accumulator)
+                    accumulator->push(*it);
+            }
+            return it;
+        }
+
+        template <size_t I>
+        static char const * feed_field(partial_frame & frame, char const * it, char const * last, uint8_t & sum) noexcept
+        {
+            return take(&std::get<I>(frame.fields_), it, last, sum);
+        }
+
+        template <size_t... I>
+        static constexpr std::array<feeder, sizeof...(FIELDS)> feeders(std::index_sequence<I...>) noexcept
+        {
+            return {&feed_field<I>...};
+        }
+
+        template <size_t... I>
+        bool finish(FRAME & frame, typename layout::extras & extras, std::index_sequence<I...>) const noexcept
+        {
+            auto const targets = layout::targets(frame, extras);
+            return (std::get<I>(fields_).finish(std::get<I>(targets)) && ...);
+        }
+
+    public:
+        // feeds field i, the fields past the schema are skipped
+        char const * feed(size_t i, char const * it, char const * last, uint8_t & sum) noexcept
+        {
+            static constexpr auto table = feeders(std::index_sequence_for<FIELDS...> {});
+            return (i < table.size()) ? table[i](*this, it, last, sum) : take<field_accumulator<minmea_field::character>>(nullptr, it, last, sum);
+        }
+
+        // the frame of the fields fed, the ones never fed being empty
+        bool finish(FRAME & frame) const noexcept
+        {
+            typename layout::extras extras;
+            return finish(frame, extras, std::index_sequence_for<FIELDS...> {}) && layout::finish(frame, extras);
+        }
+    };
+
+    // Decodes the sentences of the bytes pushed for the callback, in whichever chunks they come, without a ring. The
+    // traits give the stats and the longest sentence. Unlike the machine it resynchronizes at a '$' within a sentence,
+    // and after a sentence that runs too long it goes on from where it is instead of searching its bytes again. It
+    // keeps no text, so there are no proprietary sentences to pass through, and it decodes the RMC fields all or none,
+    // so there are no rmc_subset frames either: callbacks taking those are rejected.
+    template <class Callback, class Traits = default_traits>
+    class push_decoder : private Traits::stats_type
+    {
+        static_assert(!has_callback<Callback, proprietary_sentence>, "push_decoder keeps no text to pass through");
+        static_assert(!takes_some_rmc_subset<Callback>, "push_decoder decodes whole RMC frames, rmc_subset ones come from a machine");
+
+        enum class step : uint8_t
+        {
+            dollar,      // garbage up to the '$'
+            id,          // the talker and the sentence id
+            separator,   // the ',' after the id
+            fields,
+            checksum_hi, // the two hex digits after the '*'
+            checksum_lo,
+            cr,
+            lf
+        };
+
+        // the frame types that can be in progress, monostate while skipping
+        using frame_progress = std::variant<std::monostate,
+                                            partial_frame<minmea_sentence_rmc>, partial_frame<minmea_sentence_gga>,
+                                            partial_frame<minmea_sentence_gll>, partial_frame<minmea_sentence_gsa>,
+                                            partial_frame<minmea_sentence_gsv>, partial_frame<minmea_sentence_vtg>,
+                                            partial_frame<minmea_sentence_zda>, partial_frame<rmc_fix>>;
+
+        Callback callback_;
+        frame_progress frame_;
+        step step_ = step::dollar;
+        uint8_t sum_ = 0;
+        uint8_t checksum_ = 0;
+        char hi_ = 0;
+        char id_[5] {};
+        uint8_t id_size_ = 0;
+        uint8_t field_ = 0;
+        bool fields_end_ = false; // a character that is neither a field nor a ',' ends the fields
+        bool fieldless_ = false;  // a '*' right after the id, which the machine fails as it decodes the checksum digits
+        size_t size_ = 0;         // past the '$', up to the cr
+        sentence_id sentence_ = sentence_id::unknown;
+
+        constexpr typename Traits::stats_type & counters() noexcept
+        {
+            return *this;
+        }
+
+        void start() noexcept
+        {
+            step_ = step::id;
+            sum_ = 0;
+            id_size_ = 0;
+            field_ = 0;
+            fields_end_ = false;
+            fieldless_ = false;
+            size_ = 0;
+        }
+
+        void begin_frame(sentence_id id) noexcept
+        {
+            visit_sentence(id, [this](auto tag)
+            {
+                using decoded_type = typename decltype(tag)::type;
+                if constexpr (wants_frame<Callback, decoded_type>)
+                {
+                    using frame_type = std::conditional_t<has_callback<Callback, decoded_type>, decoded_type, typed_frame_t<decoded_type>>;
+                    frame_.template emplace<partial_frame<frame_type>>();
+                }
+            });
+        }
+
+        void end_frame() noexcept
+        {
+            std::visit([this](auto & partial)
+            {
+                if constexpr (!std::is_same_v<std::decay_t<decltype(partial)>, std::monostate>)
+                {
+                    frame_type_of<std::decay_t<decltype(partial)>> frame {};
+                    if (partial.finish(frame))
+                        deliver(callback_, frame);
+                    else
+                        counters().on_field_error();
+                }
+            }, frame_);
+        }
+
+        template <class PARTIAL>
+        struct frame_of;
+
+        template <class FRAME>
+        struct frame_of<partial_frame<FRAME>>
+        {
+            using type = FRAME;
+        };
+
+        template <class PARTIAL>
+        using frame_type_of = typename frame_of<PARTIAL>::type;
+
+        // a sentence gives up, the byte it gives up at is looked at again for a '$'
+        void drop() noexcept
+        {
+            step_ = step::dollar;
+        }
+
+    public:
+        using traits_type = Traits;
+        using stats_type = typename Traits::stats_type;
+
+        explicit push_decoder(Callback callback = Callback {}) : callback_(std::move(callback)) {}
+
+        void push(char const * data, size_t n) noexcept
+        {
+            counters().on_consumed(n);
+            auto it = data;
+            auto const last = data + n;
+            while (it != last)
+            {
+                if (step_ == step::dollar)
+                {
+                    auto const dollar = static_cast<char const *>(std::memchr(it, '$', last - it));
+                    counters().on_garbage((dollar ? dollar : last) - it);
+                    if (!dollar)
+                        return;
+                    it = dollar + 1;
+                    start();
+                    continue;
+                }
+                if (step_ == step::fields)
+                {
+                    auto const next = std::visit([this, it, last](auto & partial)
+                    {
+                        if constexpr (std::is_same_v<std::decay_t<decltype(partial)>, std::monostate>)
+                            return it;
+                        else
+                            return fields_end_ ? partial.feed(SIZE_MAX, it, last, sum_) : partial.feed(field_, it, last, sum_);
+                    }, frame_);
+                    size_ += next - it;
+                    it = next;
+                    if (size_ > Traits::max_sentence_size)
+                    {
+                        counters().on_resync();
+                        drop();
+                        continue;
+                    }
+                    if (it == last)
+                        return;
+                }
+
+                auto const c = *it;
+                if (c == '$') // a sentence cut short, this one starts afresh
+                {
+                    counters().on_malformed();
+                    drop();
+                    continue;
+                }
+                ++it;
+                if ((step_ < step::cr) && (++size_ > Traits::max_sentence_size)) // up to the cr, as the machine counts
+                {
+                    counters().on_resync();
+                    drop();
+                    continue;
+                }
+                switch (step_)
+                {
+                    case step::id:
+                        sum_ ^= uint8_t(c);
+                        id_[id_size_++] = c;
+                        if (id_size_ == sizeof(id_))
+                        {
+                            sentence_ = read_sentence_id(id_);
+                            counters().on_sentence(sentence_);
+                            if (registered<Callback>(sentence_))
+                            {
+                                begin_frame(sentence_);
+                                step_ = step::separator;
+                            } else
+                            {
+                                drop();
+                            }
+                        }
+                        break;
+                    case step::separator:
+                        if (c == '*')
+                        {
+                            fieldless_ = true;
+                            step_ = step::checksum_hi;
+                        } else
+                        {
+                            sum_ ^= uint8_t(c);
+                            step_ = step::fields;
+                        }
+                        break;
+                    case step::fields:
+                        if (c == '*')
+                        {
+                            step_ = step::checksum_hi;
+                        } else if ((c == '\x0D') || (c == '\x0A'))
+                        {
+                            counters().on_malformed();
+                            drop();
+                        } else
+                        {
+                            sum_ ^= uint8_t(c);
+                            if (c == ',')
+                                ++field_;
+                            else
+                                fields_end_ = true;
+                        }
+                        break;
+                    case step::checksum_hi:
+                        hi_ = c;
+                        step_ = step::checksum_lo;
+                        break;
+                    case step::checksum_lo:
+                    {
+                        auto const checksum = hex_byte(hi_, c);
+                        checksum_ = uint8_t(checksum);
+                        if (checksum > 0xFF)
+                            sum_ = ~checksum_; // fails at the end of the line
+                        step_ = step::cr;
+                        break;
+                    }
+                    case step::cr:
+                        if (c == '\x0D')
+                        {
+                            step_ = step::lf;
+                        } else
+                        {
+                            counters().on_malformed();
+                            drop();
+                        }
+                        break;
+                    case step::lf:
+                        if (c != '\x0A')
+                        {
+                            counters().on_malformed();
+                        } else if (checksum_ != sum_)
+                        {
+                            counters().on_checksum_failed();
+                        } else if (fieldless_)
+                        {
+                            counters().on_field_error();
+                        } else
+                        {
+                            end_frame();
+                        }
+                        drop();
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+
+        [[nodiscard]] constexpr stats_type const & stats() const noexcept
+        {
+            return *this;
+        }
+
+        [[nodiscard]] constexpr Callback & get_callback() noexcept
+        {
+            return callback_;
+        }
+    };
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <mapped.h>
+#include <span.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Captures of raw byte streams as they arrived, and their playback at the recorded pace, faster, or as fast as it goes,
+// to load a parser at production rates with no receiver attached. A capture file is "NMEACAP1" followed by one record
+// per chunk read: the nanoseconds since the capture began as uint64_t, the size as uint32_t, both in the byte order of
+// the machine, then the bytes.
+
+namespace serial
+{
+    constexpr char capture_magic[8] = {'N', 'M', 'E', 'A', 'C', 'A', 'P', '1'};
+
+    struct capture_chunk
+    {
+        std::chrono::nanoseconds at; // since the capture began
+        char const * data;
+        size_t size;
+    };
+
+    // Writes a capture, a record per call, timed by the steady clock from the construction on.
+    class capture_writer
+    {
+        int fd_ = -1;
+        std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+
+        bool write_all(iovec * parts, int count) noexcept
+        {
+            while (count)
+            {
+                auto written = ::writev(fd_, parts, count);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return false;
+                }
+                for (; count && static_cast<size_t>(written) >= parts->iov_len; ++parts, --count)
+                {
+                    written -= static_cast<ssize_t>(parts->iov_len);
+                }
+                if (count)
+                {
+                    parts->iov_base = static_cast<char *>(parts->iov_base) + written;
+                    parts->iov_len -= static_cast<size_t>(written);
+                }
+            }
+            return true;
+        }
+
+    public:
+        explicit capture_writer(char const * path) noexcept : fd_(::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644))
+        {
+            iovec magic {const_cast<char *>(capture_magic), sizeof(capture_magic)};
+            if (fd_ >= 0 && !write_all(&magic, 1))
+            {
+                close();
+            }
+        }
+
+        capture_writer(capture_writer const &) = delete;
+        capture_writer & operator=(capture_writer const &) = delete;
+
+        ~capture_writer()
+        {
+            close();
+        }
+
+        [[nodiscard]] bool is_open() const noexcept
+        {
+            return fd_ >= 0;
+        }
+
+        // the bytes just read
+        bool record(char const * data, size_t n) noexcept
+        {
+            return record(std::chrono::steady_clock::now() - start_, data, n);
+        }
+
+        // the bytes read at a time of the caller's, e.g. a hardware timestamp
+        bool record(std::chrono::nanoseconds at, char const * data, size_t n) noexcept
+        {
+            uint64_t const ns = static_cast<uint64_t>(at.count());
+            uint32_t const size = static_cast<uint32_t>(n);
+            iovec parts[] = {{const_cast<uint64_t *>(&ns), sizeof(ns)}, {const_cast<uint32_t *>(&size), sizeof(size)},
+                             {const_cast<char *>(data), n}};
+            return is_open() && write_all(parts, 3);
+        }
+
+        void close() noexcept
+        {
+            if (fd_ >= 0)
+            {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+    };
+
+    // A capture file mapped and indexed. A record cut short by the end of the file, as when the recording is killed, is
+    // left out. The chunks point into the mapping and are valid for as long as the capture lives.
+    class capture
+    {
+        mapped_log file_;
+        std::vector<capture_chunk> chunks_;
+        bool valid_ = false;
+
+    public:
+        explicit capture(char const * path) : file_(path)
+        {
+            auto const first = file_.data();
+            auto const last = first + file_.size();
+            if (!file_.is_open() || file_.size() < sizeof(capture_magic) || std::memcmp(first, capture_magic, sizeof(capture_magic)) != 0)
+            {
+                return;
+            }
+            constexpr size_t header = sizeof(uint64_t) + sizeof(uint32_t);
+            for (auto it = first + sizeof(capture_magic); size_t(last - it) >= header;)
+            {
+                uint64_t ns;
+                uint32_t size;
+                std::memcpy(&ns, it, sizeof(ns));
+                std::memcpy(&size, it + sizeof(ns), sizeof(size));
+                it += header;
+                if (size_t(last - it) < size)
+                {
+                    break;
+                }
+                chunks_.push_back(capture_chunk {std::chrono::nanoseconds(ns), it, size});
+                it += size;
+            }
+            valid_ = true;
+        }
+
+        [[nodiscard]] bool is_open() const noexcept
+        {
+            return valid_;
+        }
+
+        [[nodiscard]] span<capture_chunk const> chunks() const noexcept
+        {
+            return {chunks_.data(), chunks_.size()};
+        }
+
+        [[nodiscard]] size_t bytes() const noexcept
+        {
+            size_t n = 0;
+            for (auto const & chunk : chunks_)
+            {
+                n += chunk.size;
+            }
+            return n;
+        }
+
+        // from the start of the capture to its last chunk
+        [[nodiscard]] std::chrono::nanoseconds duration() const noexcept
+        {
+            return chunks_.empty() ? std::chrono::nanoseconds {} : chunks_.back().at;
+        }
+    };
+
+    struct replay_report
+    {
+        size_t bytes = 0;
+        size_t chunks = 0;
+        std::chrono::nanoseconds elapsed {};
+        std::chrono::nanoseconds behind {};               // the most a chunk was fed after it was due
+        std::vector<std::chrono::nanoseconds> latencies; // from the arrival of the last byte to the callback, sorted
+
+        // p in [0, 1], 0 if nothing was delivered
+        [[nodiscard]] std::chrono::nanoseconds percentile(double p) const noexcept
+        {
+            if (latencies.empty())
+            {
+                return {};
+            }
+            auto const rank = static_cast<size_t>(p * double(latencies.size() - 1) + 0.5);
+            return latencies[std::min(rank, latencies.size() - 1)];
+        }
+    };
+
+    // Feeds the chunks of a capture to whatever parses them, each when it is due. A chunk arrives when it is fed; the
+    // callbacks call delivered() with every frame to have its latency noted.
+    class replayer
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+    private:
+        span<capture_chunk const> chunks_;
+        clock::time_point arrival_ {};
+        replay_report report_;
+
+    public:
+        explicit replayer(span<capture_chunk const> chunks) noexcept : chunks_(chunks) {}
+
+        // speed 1 is the recorded pace, N N times as fast, 0 as fast as it goes; feed(data, n) takes every chunk
+        template <class FEED>
+        replay_report run(double speed, FEED && feed)
+        {
+            report_ = replay_report {};
+            auto const start = clock::now();
+            for (auto const & chunk : chunks_)
+            {
+                if (speed > 0)
+                {
+                    auto const due = start + std::chrono::duration_cast<clock::duration>(chunk.at / speed);
+                    std::this_thread::sleep_until(due);
+                    arrival_ = clock::now();
+                    report_.behind = std::max(report_.behind, std::chrono::duration_cast<std::chrono::nanoseconds>(arrival_ - due));
+                } else
+                {
+                    arrival_ = clock::now();
+                }
+                feed(chunk.data, chunk.size);
+                report_.bytes += chunk.size;
+                ++report_.chunks;
+            }
+            report_.elapsed = clock::now() - start;
+            std::sort(report_.latencies.begin(), report_.latencies.end());
+            return std::move(report_);
+        }
+
+        // a frame is delivered now
+        void delivered()
+        {
+            report_.latencies.push_back(clock::now() - arrival_);
+        }
+    };
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <span.h>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SERIAL_SCANNER_X86
+#endif
+
+// Delimiter scanning over the contiguous pieces of the ring. Every block of 64 bytes is classified at once into bit masks
+// of '$', CR, LF and '*' with the widest instruction set the CPU has, which is picked at start-up.
+
+namespace serial
+{
+    constexpr size_t scanner_block_size = 64;
+
+    // bit i of each mask stands for byte i of a block
+    struct delimiter_masks
+    {
+        uint64_t dollar;
+        uint64_t cr;
+        uint64_t lf;
+        uint64_t star;
+    };
+
+    using block_classifier = delimiter_masks (*)(char const * block) noexcept;
+
+    inline delimiter_masks classify_scalar(char const * block) noexcept
+    {
+        delimiter_masks masks {};
+        for (size_t i = 0; i < scanner_block_size; ++i)
+        {
+            uint64_t const bit = uint64_t {1} << i;
+            switch (block[i])
+            {
+                case '$': masks.dollar |= bit; break;
+                case '\x0D': masks.cr |= bit; break;
+                case '\x0A': masks.lf |= bit; break;
+                case '*': masks.star |= bit; break;
+                default: break;
+            }
+        }
+        return masks;
+    }
+
+#ifdef SERIAL_SCANNER_X86
+    __attribute__ ((target("sse2"))) inline delimiter_masks classify_sse2(char const * block) noexcept
+    {
+        auto const dollar = _mm_set1_epi8('$');
+        auto const cr = _mm_set1_epi8('\x0D');
+        auto const lf = _mm_set1_epi8('\x0A');
+        auto const star = _mm_set1_epi8('*');
+
+        delimiter_masks masks {};
+        for (unsigned i = 0; i < scanner_block_size / 16; ++i)
+        {
+            auto const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const *>(block + 16 * i));
+            auto const mask = [&bytes, i](__m128i const & what)
+            {
+                return uint64_t {static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, what)))} << (16 * i);
+            };
+            masks.dollar |= mask(dollar);
+            masks.cr |= mask(cr);
+            masks.lf |= mask(lf);
+            masks.star |= mask(star);
+        }
+        return masks;
+    }
+
+    __attribute__ ((target("avx2"))) inline delimiter_masks classify_avx2(char const * block) noexcept
+    {
+        auto const dollar = _mm256_set1_epi8('$');
+        auto const cr = _mm256_set1_epi8('\x0D');
+        auto const lf = _mm256_set1_epi8('\x0A');
+        auto const star = _mm256_set1_epi8('*');
+
+        auto const low = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block));
+        auto const high = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block + 32));
+        auto const mask = [&low, &high](__m256i const & what) __attribute__ ((target("avx2")))
+        {
+            return uint64_t {static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, what)))} |
+                   uint64_t {static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, what)))} << 32u;
+        };
+        return {mask(dollar), mask(cr), mask(lf), mask(star)};
+    }
+#endif
+
+    inline block_classifier select_classifier() noexcept
+    {
+#ifdef SERIAL_SCANNER_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return classify_avx2;
+        if (__builtin_cpu_supports("sse2"))
+            return classify_sse2;
+#endif
+        return classify_scalar;
+    }
+
+    // the classifier of this CPU, chosen on the first call, so that parsing from a static initializer finds it too
+    [[nodiscard]] inline block_classifier classifier() noexcept
+    {
+        static block_classifier const classify = select_classifier();
+        return classify;
+    }
+
+    enum delimiter : unsigned
+    {
+        dollar_delimiter = 1u,
+        crlf_delimiter = 2u,
+        star_delimiter = 4u
+    };
+
+    // offsets from the beginning of the first segment, equal to the total size for delimiters not found
+    struct delimiter_offsets
+    {
+        size_t dollar;
+        size_t crlf; // of the CR
+        size_t star;
+    };
+
+    // Finds the first of each delimiter asked for in one pass over both segments; stops as soon as all of them are found.
+    [[nodiscard]] inline delimiter_offsets find_delimiters(ring_segments const & segments, unsigned wanted,
+                                                           block_classifier classify = classifier()) noexcept
+    {
+        auto const total = segments.size();
+        delimiter_offsets offsets {total, total, total};
+
+        size_t base = 0;
+        bool cr_carry = false; // CR as the last byte of the previous block
+        for (auto const & segment : {segments.first, segments.second})
+        {
+            for (size_t pos = 0; (pos < segment.size()) && wanted; pos += scanner_block_size)
+            {
+                auto const len = std::min(scanner_block_size, segment.size() - pos);
+                delimiter_masks masks;
+                if (len == scanner_block_size)
+                {
+                    masks = classify(segment.data() + pos);
+                } else
+                {
+                    char block[scanner_block_size] {};
+                    std::memcpy(block, segment.data() + pos, len);
+                    masks = classify(block);
+                }
+
+                auto const at = base + pos;
+                if ((wanted & dollar_delimiter) && masks.dollar)
+                {
+                    offsets.dollar = at + __builtin_ctzll(masks.dollar);
+                    wanted &= ~dollar_delimiter;
+                }
+                if ((wanted & star_delimiter) && masks.star)
+                {
+                    offsets.star = at + __builtin_ctzll(masks.star);
+                    wanted &= ~star_delimiter;
+                }
+                if (wanted & crlf_delimiter)
+                {
+                    auto const crlf = masks.cr & (masks.lf >> 1u);
+                    if (cr_carry && (masks.lf & 1u))
+                    {
+                        offsets.crlf = at - 1;
+                        wanted &= ~crlf_delimiter;
+                    } else if (crlf)
+                    {
+                        offsets.crlf = at + __builtin_ctzll(crlf);
+                        wanted &= ~crlf_delimiter;
+                    }
+                    cr_carry = (masks.cr >> (len - 1)) & 1u;
+                }
+            }
+            base += segment.size();
+        }
+        return offsets;
+    }
+}
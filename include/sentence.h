@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <variant>
+#include <tokenizer.h>
+#include <checksum.h>
+
+// Sentence framing over contiguous memory. It mirrors the decisions the machine states take over the ring buffer,
+// so that chunks holding whole sentences can be handled in place, with raw pointers.
+
+namespace serial
+{
+    constexpr uint16_t max_sentence_size = 82; // the default, traits can have a longer one
+
+    enum class sentence_id : uint8_t
+    {
+        unknown,
+        rmc,
+        gga,
+        gll,
+        gsa,
+        gsv,
+        vtg,
+        zda,
+        proprietary // $P followed by a maker code, passed through as it is
+    };
+
+    [[nodiscard]] constexpr uint32_t sentence_key(char a, char b, char c) noexcept
+    {
+        return (uint32_t((uint8_t)a) << 16u) | (uint32_t((uint8_t)b) << 8u) | uint32_t((uint8_t)c);
+    }
+
+    // the three letters after the talker id
+    [[nodiscard]] constexpr sentence_id to_sentence_id(char a, char b, char c) noexcept
+    {
+        switch (sentence_key(a, b, c))
+        {
+            case sentence_key('R', 'M', 'C'): return sentence_id::rmc;
+            case sentence_key('G', 'G', 'A'): return sentence_id::gga;
+            case sentence_key('G', 'L', 'L'): return sentence_id::gll;
+            case sentence_key('G', 'S', 'A'): return sentence_id::gsa;
+            case sentence_key('G', 'S', 'V'): return sentence_id::gsv;
+            case sentence_key('V', 'T', 'G'): return sentence_id::vtg;
+            case sentence_key('Z', 'D', 'A'): return sentence_id::zda;
+            default: return sentence_id::unknown;
+        }
+    }
+
+    // the id of a sentence from its first bytes after '$'
+    template <class IT>
+    [[nodiscard]] constexpr sentence_id read_sentence_id(IT start) noexcept
+    {
+        return (*start == 'P') ? sentence_id::proprietary : to_sentence_id(start[2], start[3], start[4]);
+    }
+
+    // A proprietary sentence handed to a callback taking it, from the 'P' up to the checksum digits, checked already.
+    // The text is where it was parsed, in the ring or in the chunk, and is valid during the call only.
+    struct proprietary_sentence
+    {
+        ring_segments text;
+    };
+
+    template <class FRAME>
+    struct sentence_tag
+    {
+        using type = FRAME;
+    };
+
+    // calls f with the tag of the frame type a sentence decodes to, void for an unknown sentence
+    template <class F>
+    constexpr decltype(auto) visit_sentence(sentence_id id, F && f)
+    {
+        switch (id)
+        {
+            case sentence_id::rmc: return f(sentence_tag<minmea_sentence_rmc>{});
+            case sentence_id::gga: return f(sentence_tag<minmea_sentence_gga>{});
+            case sentence_id::gll: return f(sentence_tag<minmea_sentence_gll>{});
+            case sentence_id::gsa: return f(sentence_tag<minmea_sentence_gsa>{});
+            case sentence_id::gsv: return f(sentence_tag<minmea_sentence_gsv>{});
+            case sentence_id::vtg: return f(sentence_tag<minmea_sentence_vtg>{});
+            case sentence_id::zda: return f(sentence_tag<minmea_sentence_zda>{});
+            default: return f(sentence_tag<void>{});
+        }
+    }
+
+    // a frame of any known sentence
+    using any_sentence = std::variant<minmea_sentence_rmc, minmea_sentence_gga, minmea_sentence_gll, minmea_sentence_gsa,
+                                      minmea_sentence_gsv, minmea_sentence_vtg, minmea_sentence_zda>;
+
+    template <class FRAME>
+    constexpr sentence_id sentence_id_of = sentence_id::unknown;
+    template <> inline constexpr sentence_id sentence_id_of<minmea_sentence_rmc> = sentence_id::rmc;
+    template <> inline constexpr sentence_id sentence_id_of<minmea_sentence_gga> = sentence_id::gga;
+    template <> inline constexpr sentence_id sentence_id_of<minmea_sentence_gll> = sentence_id::gll;
+    template <> inline constexpr sentence_id sentence_id_of<minmea_sentence_gsa> = sentence_id::gsa;
+    template <> inline constexpr sentence_id sentence_id_of<minmea_sentence_gsv> = sentence_id::gsv;
+    template <> inline constexpr sentence_id sentence_id_of<minmea_sentence_vtg> = sentence_id::vtg;
+    template <> inline constexpr sentence_id sentence_id_of<minmea_sentence_zda> = sentence_id::zda;
+
+    enum class sentence_status
+    {
+        none,            // no '$' left, all the bytes are garbage
+        partial,         // a sentence starts but is not terminated yet
+        foreign,         // a sentence nobody registered for
+        oversize,        // no CR-LF within the maximum sentence size
+        malformed,       // no checksum field
+        checksum_failed,
+        accepted
+    };
+
+    struct flat_sentence
+    {
+        sentence_status status;
+        sentence_id id;
+        char const * begin; // first byte after '$'
+        char const * end;   // CR
+        char const * next;  // where to continue from
+    };
+
+    // max_size is the longest sentence framed, counted from past the '$' up to the CR
+    template <class REGISTERED>
+    [[nodiscard]] flat_sentence next_sentence(char const * first, char const * last, REGISTERED registered,
+                                              uint16_t max_size = max_sentence_size) noexcept
+    {
+        auto const dollar = static_cast<char const *>(std::memchr(first, '$', last - first));
+        if (!dollar)
+        {
+            return {sentence_status::none, sentence_id::unknown, last, last, last};
+        }
+
+        auto const start = dollar + 1;
+        if (last - start <= 4)
+        {
+            return {sentence_status::partial, sentence_id::unknown, start, last, dollar};
+        }
+        auto const id = read_sentence_id(start);
+        if (!registered(id))
+        {
+            return {sentence_status::foreign, id, start, start, start};
+        }
+
+        auto cr = start + 5;
+        while ((cr = static_cast<char const *>(std::memchr(cr, '\x0D', last - cr))) && (cr + 1 != last) && (cr[1] != '\x0A'))
+        {
+            ++cr;
+        }
+        if (!cr || cr + 1 == last)
+        {
+            if ((last - 1) - start > max_size) // the CR-LF can not come in time any more
+            {
+                return {sentence_status::oversize, id, start, last, start + (max_size >> 1u)};
+            }
+            return {sentence_status::partial, id, start, last, dollar};
+        }
+
+        auto const size = cr - start;
+        if (size > max_size)
+        {
+            return {sentence_status::oversize, id, start, cr, start + (max_size >> 1u)};
+        }
+        if (cr[-3] != '*')
+        {
+            return {sentence_status::malformed, id, start, cr, cr + 2};
+        }
+
+        auto const msg_checksum = hex_byte(cr[-2], cr[-1]);
+        if ((msg_checksum > 0xFF) || (msg_checksum != xor_bytes(start, (cr - 3) - start)))
+        {
+            return {sentence_status::checksum_failed, id, start, cr, cr + 2};
+        }
+        return {sentence_status::accepted, id, start, cr, cr + 2};
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+
+namespace serial
+{
+    // a non-owning view over contiguous memory, for as long as the language standard in use has none
+    template <class T>
+    class span
+    {
+        T * data_ {nullptr};
+        size_t size_ {0};
+    public:
+        constexpr span() noexcept = default;
+        constexpr span(T * data, size_t size) noexcept : data_(data), size_(size) {}
+        template <size_t N>
+        constexpr span(T (&array)[N]) noexcept : data_(array), size_(N) {}
+
+        [[nodiscard]] constexpr T * data() const noexcept
+        {
+            return data_;
+        }
+
+        [[nodiscard]] constexpr size_t size() const noexcept
+        {
+            return size_;
+        }
+
+        [[nodiscard]] constexpr bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        [[nodiscard]] constexpr T * begin() const noexcept
+        {
+            return data_;
+        }
+
+        [[nodiscard]] constexpr T * end() const noexcept
+        {
+            return data_ + size_;
+        }
+
+        [[nodiscard]] constexpr T & operator[](size_t i) const noexcept
+        {
+            return data_[i];
+        }
+    };
+
+    // bytes of a ring buffer: the piece up to the physical end of the buffer and the wrapped one from its start
+    struct ring_segments
+    {
+        span<char const> first;
+        span<char const> second;
+
+        [[nodiscard]] constexpr size_t size() const noexcept
+        {
+            return first.size() + second.size();
+        }
+    };
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <machine.h>
+#include <atomic>
+#include <thread>
+
+// A machine fed from another thread. One producer thread fills bytes in while one consumer thread parses them: the bytes
+// go through a ring of their own whose head and tail are atomics on separate cache lines, and the consumer parses them
+// in place with the span parse of the machine, which copies only the sentences cut by the ring end or by a fill.
+
+namespace serial
+{
+    constexpr size_t cache_line_size = 64;
+
+    template <size_t bs, class Callback, class Traits = default_traits>
+    class spsc_machine
+    {
+        struct alignas(cache_line_size) producer_side
+        {
+            std::atomic<size_t> head {0}; // bytes filled in so far
+            size_t tail_seen = 0;         // the last tail loaded, enough as long as it shows room
+            std::atomic<uint64_t> overflows {0};
+        };
+
+        struct alignas(cache_line_size) consumer_side
+        {
+            std::atomic<size_t> tail {0}; // bytes parsed so far
+            size_t head_seen = 0;
+        };
+
+        producer_side producer_;
+        consumer_side consumer_;
+        alignas(cache_line_size) char buffer_[bs] {};
+        machine<bs, Callback, Traits> machine_;
+
+    public:
+        // What the producer does with the bytes that do not fit: it waits with the blocking policy, and it drops them with
+        // either dropping one, since the oldest bytes are the consumer's to parse and can not be taken back.
+        static constexpr overflow_policy overflow =
+                (Traits::overflow == overflow_policy::block) ? overflow_policy::block : overflow_policy::drop_newest;
+
+        explicit spsc_machine(Callback callback = Callback {}) : machine_(std::move(callback)) {}
+
+        spsc_machine(spsc_machine const &) = delete;
+        spsc_machine & operator=(spsc_machine const &) = delete;
+
+        // producer: the bytes that can be filled in right now
+        [[nodiscard]] size_t available() noexcept
+        {
+            producer_.tail_seen = consumer_.tail.load(std::memory_order_acquire);
+            return bs - (producer_.head.load(std::memory_order_relaxed) - producer_.tail_seen);
+        }
+
+        // producer: takes as many of the bytes as fit and tells how many that is
+        size_t try_fill(char const * data, size_t n) noexcept
+        {
+            auto const head = producer_.head.load(std::memory_order_relaxed);
+            if (bs - (head - producer_.tail_seen) < n)
+            {
+                producer_.tail_seen = consumer_.tail.load(std::memory_order_acquire);
+            }
+            auto const accepted = std::min(n, bs - (head - producer_.tail_seen));
+            auto const at = head % bs;
+            auto const first = std::min(accepted, bs - at);
+            std::memcpy(buffer_ + at, data, first);
+            std::memcpy(buffer_, data + first, accepted - first);
+            producer_.head.store(head + accepted, std::memory_order_release);
+            return accepted;
+        }
+
+        // producer: takes all of the bytes, or as many as fit and drops the rest, as the overflow above says
+        void fill_data(char const * data, size_t n) noexcept
+        {
+            auto accepted = try_fill(data, n);
+            if (accepted == n)
+            {
+                return;
+            }
+            producer_.overflows.fetch_add(1, std::memory_order_relaxed);
+            if constexpr (overflow == overflow_policy::block)
+            {
+                while (accepted != n)
+                {
+                    std::this_thread::yield();
+                    accepted += try_fill(data + accepted, n - accepted);
+                }
+            }
+        }
+
+        // the fills that did not fit at once
+        [[nodiscard]] uint64_t overflow_events() const noexcept
+        {
+            return producer_.overflows.load(std::memory_order_relaxed);
+        }
+
+        // consumer: parses the bytes filled in so far, false if there were none
+        bool parse() noexcept
+        {
+            auto const tail = consumer_.tail.load(std::memory_order_relaxed);
+            if (consumer_.head_seen == tail)
+            {
+                consumer_.head_seen = producer_.head.load(std::memory_order_acquire);
+                if (consumer_.head_seen == tail)
+                {
+                    return false;
+                }
+            }
+            auto const n = consumer_.head_seen - tail;
+            auto const at = tail % bs;
+            auto const first = std::min(n, bs - at);
+            machine_.parse(buffer_ + at, first);
+            if (n != first)
+            {
+                machine_.parse(buffer_, n - first);
+            }
+            consumer_.tail.store(tail + n, std::memory_order_release);
+            return true;
+        }
+
+        // consumer: whether all of the bytes filled in so far are parsed
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return producer_.head.load(std::memory_order_acquire) == consumer_.tail.load(std::memory_order_relaxed);
+        }
+
+        // consumer: the machine doing the parsing, e.g. for its stats
+        [[nodiscard]] machine<bs, Callback, Traits> const & get_machine() const noexcept
+        {
+            return machine_;
+        }
+
+        [[nodiscard]] Callback & get_callback() noexcept
+        {
+            return machine_.get_callback();
+        }
+    };
+}
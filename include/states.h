@@ -3,6 +3,10 @@
 #include <memory>
 #include <iostream>
 #include <ring_iter.h>
+#include <sentence.h>
+#include <scanner.h>
+#include <checksum.h>
+#include <mach_mem.h>
 
 #ifdef _MSC_VER
 #pragma warning(disable : 4625)
@@ -14,16 +18,26 @@
 
 namespace serial
 {
-    class state
+    // The states are plain members of the machine, which switches over this id to run the current one,
+    // so every transition is visible to the compiler.
+    enum class state_id : uint8_t
     {
-    public:
-        virtual ~state() = default;
-        virtual bool parse() = 0;
-        virtual void cleanup() {}
+        parse_$,
+        parse_id,
+        parse_crlf,
+        parse_checksum
     };
 
+    constexpr size_t state_count = 4;
+
+    inline std::ostream & operator<<(std::ostream & os, state_id id)
+    {
+        char const * const names[] {"parse_$", "parse_id", "parse_crlf", "parse_checksum"};
+        return os << names[static_cast<uint8_t>(id)];
+    }
+
     template <typename MACHINE>
-    class parent_state : public state
+    class parent_state
     {
     protected:
         using machine_type = MACHINE&;
@@ -34,6 +48,8 @@ namespace serial
         parent_state& operator=(const parent_state&) = delete;
         parent_state(parent_state&&) = delete;
         parent_state& operator=(parent_state&&) = delete;
+
+        void cleanup() noexcept {}
     };
 
     template <typename MACHINE>
@@ -44,61 +60,59 @@ namespace serial
     public:
         explicit Parse$State (decltype(machine_) machine) : parent_class_type(machine) {}
 
-        bool parse() noexcept override
+        bool parse() noexcept
         {
-            auto const __ = std::find(std::begin(machine_), machine_.end(), '$');
-            if (__ == machine_.end())
+            auto const offset = find_delimiters(machine_.segments(), dollar_delimiter).dollar;
+            machine_.counters().on_garbage(offset);
+            if (offset == machine_.size())
             {
                 machine_.align();
                 return false;
             } else
             {
-                machine_.align(__+1);
-                machine_.set_state(machine_.get_parse_rmc_state()); // cleanup call here
+                machine_.probe().on_dollar();
+                machine_.align(machine_.begin() + (offset + 1));
+                machine_.set_state(state_id::parse_id); // cleanup call here
                 return true;
             }
         }
 
-        void cleanup() noexcept final
+        void cleanup() noexcept
         {
             machine_.save_start(machine_.begin());
         }
-        static char storage[100] __attribute__ ((aligned));
     };
-    template <typename M>
-    char Parse$State<M>::storage[100] __attribute__ ((aligned));
 
     template <typename MACHINE>
-    class ParseRmcState final : public parent_state<MACHINE>
+    class ParseIdState final : public parent_state<MACHINE>
     {
         using parent_class_type = parent_state<MACHINE>;
         using parent_class_type::machine_;
     public:
-        explicit ParseRmcState (decltype(machine_) machine) : parent_class_type(machine) {}
+        explicit ParseIdState (decltype(machine_) machine) : parent_class_type(machine) {}
 
-        bool parse() noexcept override
+        bool parse() noexcept
         {
             if (machine_.size() > 4)
             {
-                std::array<char, 3> constexpr rmc_seq {'R', 'M', 'C'};
-                auto const __ = std::search (machine_.begin(), machine_.end(), rmc_seq.begin(), rmc_seq.end());
-                if ((__ == machine_.end()) || (machine_.distance(machine_.get_start(), __) != 2))
+                auto const talker_end = machine_.begin() + 2;
+                auto const id = read_sentence_id(machine_.begin());
+                machine_.counters().on_sentence(id);
+                if (!machine_.registered(id))
                 {
-                    machine_.align();
-                    machine_.set_state(machine_.get_parse_$_state());
+                    // skipped undecoded, the next '$' is searched for right after this one
+                    machine_.set_state(state_id::parse_$);
                 } else
                 {
-                    machine_.align(__ + sizeof(rmc_seq));
-                    machine_.set_state(machine_.get_parse_crlf_state());
+                    machine_.save_id(id);
+                    machine_.align(talker_end + 3);
+                    machine_.set_state(state_id::parse_crlf);
                 }
                 return true;
             }
             return false;
         }
-        static char storage[100] __attribute__ ((aligned));
     };
-    template <typename M>
-    char ParseRmcState<M>::storage[100] __attribute__ ((aligned));
 
 
     template <typename MACHINE>
@@ -107,23 +121,28 @@ namespace serial
         using parent_class_type = parent_state<MACHINE>;
         using parent_class_type::machine_;
 
-        static constexpr uint8_t max_msg_size = 82;
+        // of the traits, read once the machine is complete
+        [[nodiscard]] static constexpr size_t max_msg_size() noexcept
+        {
+            return MACHINE::traits_type::max_sentence_size;
+        }
 
-        template <class IT>
-        void handle_adhesion(IT const & it) const noexcept // handles the absence of cr-lf between two messages
+        // handles the absence of cr-lf between two messages: the search goes on from halfway through the sentence, with
+        // all of the bytes after it, those past a cr-lf found too
+        void handle_adhesion() const noexcept
         {
-            machine_.reset(machine_.get_start(), it);
-            machine_.align(machine_.begin() + (max_msg_size >> 1u));
+            machine_.reset(machine_.get_start(), machine_.end());
+            machine_.align(machine_.begin() + (max_msg_size() >> 1u));
         }
 
-        uint16_t msg_size = 0;
-        template <class IT>
-        [[nodiscard]] bool on_max_msg_size(IT const & it) const noexcept
+        size_t msg_size = 0;
+        [[nodiscard]] bool on_max_msg_size() const noexcept
         {
-            if (msg_size > max_msg_size)
+            if (msg_size > max_msg_size())
             {
-                handle_adhesion(it);
-                machine_.set_state(machine_.get_parse_$_state());
+                machine_.counters().on_resync();
+                handle_adhesion();
+                machine_.set_state(state_id::parse_$);
                 return true;
             }
             return false;
@@ -131,19 +150,19 @@ namespace serial
     public:
         explicit ParseCrlfState (decltype(machine_) machine) : parent_class_type(machine) {}
 
-        bool parse() noexcept override
+        bool parse() noexcept
         {
             if (machine_.size() > 1)
             {
                 std::array<char, 2> constexpr crlf_seq {'\x0D', '\x0A'};
-                auto const __ = std::search (machine_.begin(), machine_.end(), crlf_seq.begin(), crlf_seq.end());
+                auto const __ = machine_.begin() + find_delimiters(machine_.segments(), crlf_delimiter).crlf;
 
                 if (__ == machine_.end())
                 {
                     auto const sz = machine_.size();
                     machine_.align(std::begin(machine_) + (sz - 1));
                     msg_size += (sz - 1);
-                    return on_max_msg_size(machine_.end());
+                    return on_max_msg_size();
                 } else
                 {
                     machine_memento<MACHINE> mm(machine_);
@@ -152,11 +171,12 @@ namespace serial
                     msg_size = machine_.size();
                     machine_.unchecked_rollback(mm);
 
-                    if (!on_max_msg_size(__ + sizeof(crlf_seq)))
+                    if (!on_max_msg_size())
                     {
+                        machine_.probe().on_crlf();
                         machine_.save_stop(__);
                         machine_.align(__ + sizeof(crlf_seq));
-                        machine_.set_state(machine_.get_parse_checksum_state());
+                        machine_.set_state(state_id::parse_checksum);
                     }
                     return true;
                 }
@@ -164,14 +184,16 @@ namespace serial
             return false;
         }
 
-        void cleanup() noexcept final
+        void cleanup() noexcept
         {
             msg_size = 0;
         }
-        static char storage[100] __attribute__ ((aligned));
+
+        void adopt(ParseCrlfState const & other) noexcept // takes over the progress of a relocated machine
+        {
+            msg_size = other.msg_size;
+        }
     };
-    template <typename M>
-    char ParseCrlfState<M>::storage[100] __attribute__ ((aligned));
 
     // caretaker (memento pattern)
     template <typename MACHINE>
@@ -180,55 +202,44 @@ namespace serial
         using parent_class_type = parent_state<MACHINE>;
         using parent_class_type::machine_;
         machine_memento<MACHINE> mm;
-        char msg_checksum[3] {0,0,'\0'};
-
-        [[nodiscard]] int8_t calc_cs() const noexcept
-        {
-            // not a range-based loop in order to not checking for '*' on each cycle
-            auto sum = *machine_.begin();
-            std::for_each(machine_.begin()+1, machine_.begin()+(machine_.size()-3), [&sum](char elem)
-                          {
-                              sum ^= (uint8_t)elem;
-                          }
-            );
-            return sum;
-        }
 
     public:
         explicit ParseChecksumState(decltype(machine_) machine) : parent_class_type(machine), mm(machine) {}
 
-        bool parse() noexcept final
+        bool parse() noexcept
         {
             mm = machine_.check_point();
 
             machine_.reset(machine_.get_start(), machine_.get_stop());
-            auto const star_it = machine_.begin() + (machine_.size() - 3);
+            auto const size = machine_.size();
+            auto const star_it = machine_.begin() + (size - 3);
 
             if ('*' != *star_it)
             {
-                machine_.set_state(machine_.get_parse_$_state());
+                machine_.counters().on_malformed();
+                machine_.set_state(state_id::parse_$);
                 return true;
             }
 
-            std::uninitialized_copy (machine_.begin() + (machine_.size() - 2), machine_.begin() + (machine_.size() - 0), msg_checksum);
-
-            if (calc_cs() == strtol(msg_checksum, nullptr, 16))
+            // the digits first, so that a garbled tail costs no pass over the sentence
+            auto const msg_checksum = hex_byte(*(star_it + 1), *(star_it + 2));
+            if ((msg_checksum <= 0xFF) && (msg_checksum == xor_bytes(machine_.segments(machine_.begin(), size - 3))))
             {
                 machine_.process();
+            } else
+            {
+                machine_.counters().on_checksum_failed();
             }
 
-            machine_.set_state(machine_.get_parse_$_state());
+            machine_.set_state(state_id::parse_$);
             return true;
         }
 
-        void cleanup() noexcept final
+        void cleanup() noexcept
         {
             machine_.rollback(mm);
         }
-        static char storage[100] __attribute__ ((aligned));
     };
-    template <typename M>
-    char ParseChecksumState<M>::storage[100] __attribute__ ((aligned));
 
 }
 
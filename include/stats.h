@@ -0,0 +1,210 @@
+#pragma once
+
+#include <sentence.h>
+#include <algorithm>
+#include <cstdint>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// What a machine counts and times, picked through its traits. The machine calls the on_* hooks of its stats type as
+// bytes and sentences go by, wraps every state run with its profiler, and stamps the sentences with its latency probe;
+// the types that do nothing are empty and their calls compile away.
+
+namespace serial
+{
+    constexpr size_t sentence_id_count = static_cast<size_t>(sentence_id::proprietary) + 1;
+
+    struct no_stats
+    {
+        static constexpr bool enabled = false;
+
+        constexpr void on_consumed(size_t) noexcept {}
+        constexpr void on_garbage(size_t) noexcept {}
+        constexpr void on_sentence(sentence_id) noexcept {}
+        constexpr void on_checksum_failed() noexcept {}
+        constexpr void on_resync() noexcept {}
+        constexpr void on_malformed() noexcept {}
+        constexpr void on_field_error() noexcept {}
+        constexpr void on_ring_full() noexcept {}
+        constexpr void on_dropped(size_t) noexcept {}
+    };
+
+    struct parser_stats
+    {
+        static constexpr bool enabled = true;
+
+        uint64_t bytes_consumed = 0;  // given to fill_data() or parse()
+        uint64_t garbage_bytes = 0;   // skipped looking for '$'
+        uint64_t sentences[sentence_id_count] {}; // seen by id, whether registered or not
+        uint64_t checksum_failures = 0;
+        uint64_t resyncs = 0;         // no CR-LF within the maximum sentence size
+        uint64_t malformed = 0;       // no checksum field
+        uint64_t field_errors = 0;    // fields that do not decode
+        uint64_t ring_full_events = 0; // more bytes filled in than the ring had room for
+        uint64_t dropped_bytes = 0;   // lost to the overflow policy
+
+        constexpr void on_consumed(size_t n) noexcept
+        {
+            bytes_consumed += n;
+        }
+
+        constexpr void on_garbage(size_t n) noexcept
+        {
+            garbage_bytes += n;
+        }
+
+        constexpr void on_sentence(sentence_id id) noexcept
+        {
+            ++sentences[static_cast<size_t>(id)];
+        }
+
+        constexpr void on_checksum_failed() noexcept
+        {
+            ++checksum_failures;
+        }
+
+        constexpr void on_resync() noexcept
+        {
+            ++resyncs;
+        }
+
+        constexpr void on_malformed() noexcept
+        {
+            ++malformed;
+        }
+
+        constexpr void on_field_error() noexcept
+        {
+            ++field_errors;
+        }
+
+        constexpr void on_ring_full() noexcept
+        {
+            ++ring_full_events;
+        }
+
+        constexpr void on_dropped(size_t n) noexcept
+        {
+            dropped_bytes += n;
+        }
+    };
+
+    struct no_profiler
+    {
+        static constexpr bool enabled = false;
+
+        template <class STATE>
+        constexpr void on_stage(STATE, uint64_t) noexcept {}
+    };
+
+    // timestamps in CPU cycles where the counter is at hand, in nanoseconds elsewhere
+    [[nodiscard]] inline uint64_t cycle_count() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // the bucket of [2^i, 2^(i+1)), the last one taking the rest
+    [[nodiscard]] constexpr size_t log2_bucket(uint64_t n, size_t buckets) noexcept
+    {
+        return n ? std::min<size_t>(63 - __builtin_clzll(n), buckets - 1) : 0;
+    }
+
+    // Per stage, how many runs took 0-1, 2-3, 4-7, ... cycles: bucket i counts the runs of [2^i, 2^(i+1)) cycles.
+    template <size_t STAGES>
+    struct cycle_histogram
+    {
+        static constexpr bool enabled = true;
+        static constexpr size_t buckets = 32;
+
+        uint64_t runs[STAGES][buckets] {};
+
+        template <class STATE>
+        void on_stage(STATE stage, uint64_t cycles) noexcept
+        {
+            ++runs[static_cast<size_t>(stage)][log2_bucket(cycles, buckets)];
+        }
+    };
+
+    // The clocks of a latency probe, in ticks of their own: the cycle counter, or nanoseconds of the steady clock.
+    struct tsc_clock
+    {
+        [[nodiscard]] static uint64_t now() noexcept
+        {
+            return cycle_count();
+        }
+    };
+
+    struct steady_tick_clock
+    {
+        [[nodiscard]] static uint64_t now() noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+    };
+
+    // when a sentence got through the machine, in ticks of the probe's clock
+    struct sentence_times
+    {
+        uint64_t dollar;   // its '$' found
+        uint64_t crlf;     // its CR-LF found, the last byte in
+        uint64_t callback; // its callback entered
+    };
+
+    struct no_latency
+    {
+        static constexpr bool enabled = false;
+
+        constexpr void on_dollar() noexcept {}
+        constexpr void on_crlf() noexcept {}
+        constexpr void on_callback(sentence_id) noexcept {}
+    };
+
+    // Bucket i counts the sentences of [2^i, 2^(i+1)) ticks from the '$' to the callback, and from the CR-LF to it.
+    struct latency_histogram
+    {
+        static constexpr size_t buckets = 32;
+
+        uint64_t from_dollar[buckets] {};
+        uint64_t from_crlf[buckets] {};
+
+        void operator()(sentence_id, sentence_times const & times) noexcept
+        {
+            ++from_dollar[log2_bucket(times.callback - times.dollar, buckets)];
+            ++from_crlf[log2_bucket(times.callback - times.crlf, buckets)];
+        }
+    };
+
+    // Stamps every sentence on its way and hands the times to the sink, sink(id, times), right before the callback is
+    // called with the frame, so a sink can pair them up with the frames or count them as latency_histogram does.
+    template <class CLOCK = tsc_clock, class SINK = latency_histogram>
+    struct latency_probe
+    {
+        static constexpr bool enabled = true;
+
+        SINK sink {};
+        uint64_t dollar = 0;
+        uint64_t crlf = 0;
+
+        void on_dollar() noexcept
+        {
+            dollar = CLOCK::now();
+        }
+
+        void on_crlf() noexcept
+        {
+            crlf = CLOCK::now();
+        }
+
+        void on_callback(sentence_id id) noexcept
+        {
+            sink(id, sentence_times {dollar, crlf, CLOCK::now()});
+        }
+    };
+}
@@ -1,12 +1,13 @@
 #pragma once
 
-#include <cstdarg>
-#include <cmath>
-#include <cassert>
+#include <cstdint>
 #include <cctype> //isprintf, isdigit
+#include <tuple>
+#include <utility>
 
 // This code is borrowed from minmea parser by Kosma Moczek and has been slightly modified.
 // It is armed with ring buffer iterator that is being used throughout the parser environment.
+// The format string interpreter (minmea_scan) is replaced with sentence schemas resolved at compile time.
 
 namespace serial
 {
@@ -39,227 +40,567 @@ namespace serial
         struct minmea_float variation;
     };
 
-    bool minmea_isfield(char c) noexcept {
+    struct minmea_sentence_gga {
+        struct minmea_time time;
+        struct minmea_float latitude;
+        struct minmea_float longitude;
+        int fix_quality;
+        int satellites_tracked;
+        struct minmea_float hdop;
+        struct minmea_float altitude; char altitude_units;
+        struct minmea_float height; char height_units;
+        struct minmea_float dgps_age;
+    };
+
+    struct minmea_sentence_gll {
+        struct minmea_float latitude;
+        struct minmea_float longitude;
+        struct minmea_time time;
+        char status;
+        char mode;
+    };
+
+    struct minmea_sentence_gsa {
+        char mode;
+        int fix_type;
+        int sats[12];
+        struct minmea_float pdop;
+        struct minmea_float hdop;
+        struct minmea_float vdop;
+    };
+
+    struct minmea_sat_info {
+        int nr;
+        int elevation;
+        int azimuth;
+        int snr;
+    };
+
+    struct minmea_sentence_gsv {
+        int total_msgs;
+        int msg_nr;
+        int total_sats;
+        struct minmea_sat_info sats[4];
+    };
+
+    struct minmea_sentence_vtg {
+        struct minmea_float true_track_degrees;
+        struct minmea_float magnetic_track_degrees;
+        struct minmea_float speed_knots;
+        struct minmea_float speed_kph;
+        char faa_mode;
+    };
+
+    struct minmea_sentence_zda {
+        struct minmea_time time;
+        struct minmea_date date;
+        int hour_offset;
+        int minute_offset;
+    };
+
+    inline bool minmea_isfield(char c) noexcept {
         return isprint((unsigned char) c) && c != ',' && c != '*';
     }
 
-    template <typename RING_IT>
-    bool minmea_scan(RING_IT it, RING_IT it2, const char *format, ...) noexcept
+    // Field decoders of a sentence schema, one per minmea format character. Each turns the field the iterator is at
+    // into its value; an absent field (past the last comma) decodes to the default the format character defines.
+    namespace minmea_field
     {
-        bool result = false;
-        va_list ap;
-        va_start(ap, format);
-
-        auto field = it;
-#define next_field() \
-    do { \
-        /* Progress to the next field. */ \
-        while (minmea_isfield(*it)) \
-            ++it; \
-        /* Make sure there is a field there. */ \
-        if (*it == ',') { \
-            ++it; \
-            field = it; \
-        } else { \
-            field = it2; \
-            assert (!field); \
-        } \
-    } while (0)
-
-        while (*format) {
-            char type = *format++;
-
-            switch (type) {
-                case 'c': { // Single character field (char).
-                    char value = '\0';
-
-                    if (field && minmea_isfield(*field))
-                        value = *field;
-
-                    *va_arg(ap, char *) = value;
-                } break;
-
-                case 'd': { // Single character direction field (int).
-                    int value = 0;
-
-                    if (field && minmea_isfield(*field)) {
-                        switch (*field) {
-                            case 'N':
-                            case 'E':
-                                value = 1;
-                                break;
-                            case 'S':
-                            case 'W':
-                                value = -1;
-                                break;
-                            default:
-                                goto parse_error;
-                        }
+        struct character // 'c'
+        {
+            using value_type = char;
+
+            template <typename RING_IT>
+            static bool decode(RING_IT field, bool present, char & value) noexcept {
+                value = (present && minmea_isfield(*field)) ? *field : '\0';
+                return true;
+            }
+        };
+
+        struct direction // 'd', 1 for N and E, -1 for S and W
+        {
+            using value_type = int;
+
+            template <typename RING_IT>
+            static bool decode(RING_IT field, bool present, int & value) noexcept {
+                value = 0;
+                if (present && minmea_isfield(*field)) {
+                    switch (*field) {
+                        case 'N':
+                        case 'E':
+                            value = 1;
+                            break;
+                        case 'S':
+                        case 'W':
+                            value = -1;
+                            break;
+                        default:
+                            return false;
                     }
-
-                    *va_arg(ap, int *) = value;
-                } break;
-
-                case 'f': { // Fractional value with scale (struct minmea_float).
-                    int sign = 0;
-                    int_least32_t value = -1;
-                    int_least32_t scale = 0;
-
-                    if (field) {
-                        while (minmea_isfield(*field)) {
-                            if (*field == '+' && !sign && value == -1) {
-                                sign = 1;
-                            } else if (*field == '-' && !sign && value == -1) {
-                                sign = -1;
-                            } else if (isdigit((unsigned char) *field)) {
-                                int digit = *field - '0';
-                                if (value == -1)
-                                    value = 0;
-                                if (value > (INT_LEAST32_MAX-digit) / 10) {
-                                    /* we ran out of bits, what do we do? */
-                                    if (scale) {
-                                        /* truncate extra precision */
-                                        break;
-                                    } else {
-                                        /* integer overflow. bail out. */
-                                        goto parse_error;
-                                    }
+                }
+                return true;
+            }
+        };
+
+        struct fixed // 'f', fractional value with scale
+        {
+            using value_type = minmea_float;
+
+            template <typename RING_IT>
+            static bool decode(RING_IT field, bool present, minmea_float & result) noexcept {
+                int sign = 0;
+                int_least32_t value = -1;
+                int_least32_t scale = 0;
+
+                if (present) {
+                    while (minmea_isfield(*field)) {
+                        if (*field == '+' && !sign && value == -1) {
+                            sign = 1;
+                        } else if (*field == '-' && !sign && value == -1) {
+                            sign = -1;
+                        } else if (isdigit((unsigned char) *field)) {
+                            int digit = *field - '0';
+                            if (value == -1)
+                                value = 0;
+                            if (value > (INT_LEAST32_MAX-digit) / 10) {
+                                /* we ran out of bits, what do we do? */
+                                if (scale) {
+                                    /* truncate extra precision */
+                                    break;
+                                } else {
+                                    /* integer overflow. bail out. */
+                                    return false;
                                 }
-                                value = (10 * value) + digit;
-                                if (scale)
-                                    scale *= 10;
-                            } else if (*field == '.' && scale == 0) {
-                                scale = 1;
-                            } else if (*field == ' ') {
-                                /* Allow spaces at the start of the field. Not NMEA
-                                 * conformant, but some modules do this. */
-                                if (sign != 0 || value != -1 || scale != 0)
-                                    goto parse_error;
-                            } else {
-                                goto parse_error;
                             }
-                            ++field;
+                            value = (10 * value) + digit;
+                            if (scale)
+                                scale *= 10;
+                        } else if (*field == '.' && scale == 0) {
+                            scale = 1;
+                        } else if (*field == ' ') {
+                            /* Allow spaces at the start of the field. Not NMEA
+                             * conformant, but some modules do this. */
+                            if (sign != 0 || value != -1 || scale != 0)
+                                return false;
+                        } else {
+                            return false;
                         }
+                        ++field;
                     }
+                }
 
-                    if ((sign || scale) && value == -1)
-                        goto parse_error;
+                if ((sign || scale) && value == -1)
+                    return false;
 
-                    if (value == -1) {
-                        /* No digits were scanned. */
-                        value = 0;
-                        scale = 0;
-                    } else if (scale == 0) {
-                        /* No decimal point. */
-                        scale = 1;
+                if (value == -1) {
+                    /* No digits were scanned. */
+                    value = 0;
+                    scale = 0;
+                } else if (scale == 0) {
+                    /* No decimal point. */
+                    scale = 1;
+                }
+                if (sign)
+                    value *= sign;
+
+                result = minmea_float {value, scale};
+                return true;
+            }
+        };
+
+        struct integer // 'i', 0 if empty
+        {
+            using value_type = int;
+
+            template <typename RING_IT>
+            static bool decode(RING_IT field, bool present, int & value) noexcept {
+                value = 0;
+                if (present) {
+                    auto it = field;
+                    while (*it == ' ')
+                        ++it;
+                    int sign = 1;
+                    if (*it == '+' || *it == '-') {
+                        sign = (*it == '-') ? -1 : 1;
+                        ++it;
                     }
-                    if (sign)
-                        value *= sign;
-                    
-                    *va_arg(ap, struct minmea_float *) = minmea_float  {value, scale};
-                } break;
-
-                case 'D': { // Date (int, int, int), -1 if empty.
-                    struct minmea_date *date = va_arg(ap, struct minmea_date *);
-
-                    int d = -1, m = -1, y = -1;
-
-                    if (field && minmea_isfield(*field)) {
-                        // Always six digits.
-                        for (int f=0; f<6; f++)
-                            if (!isdigit((unsigned char) field[f]))
-                                goto parse_error;
-
-                        char dArr[] = {field[0], field[1], '\0'};
-                        char mArr[] = {field[2], field[3], '\0'};
-                        char yArr[] = {field[4], field[5], '\0'};
-                        d = strtol(dArr, nullptr, 10);
-                        m = strtol(mArr, nullptr, 10);
-                        y = strtol(yArr, nullptr, 10);
+                    if (isdigit((unsigned char) *it)) {
+                        long result = 0;
+                        while (isdigit((unsigned char) *it) && result <= INT_LEAST32_MAX)
+                            result = (10 * result) + (*it++ - '0');
+                        value = static_cast<int>(sign * result);
+                    } else {
+                        it = field; // nothing is converted
                     }
+                    if (minmea_isfield(*it))
+                        return false;
+                }
+                return true;
+            }
+        };
+
+        template <typename RING_IT>
+        bool six_digits(RING_IT field) noexcept {
+            for (int f=0; f<6; f++)
+                if (!isdigit((unsigned char) field[f]))
+                    return false;
+            return true;
+        }
 
-                    date->day = d;
-                    date->month = m;
-                    date->year = y;
-                } break;
-
-                case 'T': { // Time (int, int, int, int), -1 if empty.
-                    struct minmea_time *time_ = va_arg(ap, struct minmea_time *);
-
-                    int h = -1, i = -1, s = -1, u = -1;
-
-                    if (field && minmea_isfield(*field)) {
-                        // Minimum required: integer time.
-                        for (int f=0; f<6; f++)
-                            if (!isdigit((unsigned char) field[f]))
-                                goto parse_error;
-
-                        char hArr[] = {field[0], field[1], '\0'};
-                        char iArr[] = {field[2], field[3], '\0'};
-                        char sArr[] = {field[4], field[5], '\0'};
-                        h = strtol(hArr, nullptr, 10);
-                        i = strtol(iArr, nullptr, 10);
-                        s = strtol(sArr, nullptr, 10);
-                        field += 6;
-
-                        // Extra: fractional time. Saved as microseconds.
-                        if (*field++ == '.') {
-                            uint32_t value = 0;
-                            uint32_t scale = 1000000LU;
-                            while (isdigit((unsigned char) *field) && scale > 1) {
-                                value = (value * 10) + (*field++ - '0');
-                                scale /= 10;
-                            }
-                            u = value * scale;
-                        } else {
-                            u = 0;
+        template <typename RING_IT>
+        int two_digits(RING_IT field) noexcept {
+            return (field[0] - '0') * 10 + (field[1] - '0');
+        }
+
+        struct date // 'D', -1 if empty
+        {
+            using value_type = minmea_date;
+
+            template <typename RING_IT>
+            static bool decode(RING_IT field, bool present, minmea_date & date) noexcept {
+                date = minmea_date {-1, -1, -1};
+                if (present && minmea_isfield(*field)) {
+                    // Always six digits.
+                    if (!six_digits(field))
+                        return false;
+                    date = minmea_date {two_digits(field), two_digits(field + 2), two_digits(field + 4)};
+                }
+                return true;
+            }
+        };
+
+        struct time // 'T', -1 if empty
+        {
+            using value_type = minmea_time;
+
+            template <typename RING_IT>
+            static bool decode(RING_IT field, bool present, minmea_time & time_) noexcept {
+                time_ = minmea_time {-1, -1, -1, -1};
+                if (present && minmea_isfield(*field)) {
+                    // Minimum required: integer time.
+                    if (!six_digits(field))
+                        return false;
+                    time_.hours = two_digits(field);
+                    time_.minutes = two_digits(field + 2);
+                    time_.seconds = two_digits(field + 4);
+                    field += 6;
+
+                    // Extra: fractional time. Saved as microseconds.
+                    time_.microseconds = 0;
+                    if (*field++ == '.') {
+                        uint32_t value = 0;
+                        uint32_t scale = 1000000LU;
+                        while (isdigit((unsigned char) *field) && scale > 1) {
+                            value = (value * 10) + (*field++ - '0');
+                            scale /= 10;
                         }
+                        time_.microseconds = value * scale;
                     }
-
-                    time_->hours = h;
-                    time_->minutes = i;
-                    time_->seconds = s;
-                    time_->microseconds = u;
-                } break;
-
-                default: { // Unknown.
-                    goto parse_error;
                 }
+                return true;
+            }
+        };
+    }
+
+    // A sentence layout known at compile time: the fields are decoded one after another into the targets given,
+    // with no format string to interpret.
+    template <typename... FIELDS>
+    struct minmea_schema
+    {
+        template <typename RING_IT>
+        static void next_field(RING_IT & it, RING_IT & field, bool & present) noexcept {
+            /* Progress to the next field. */
+            while (minmea_isfield(*it))
+                ++it;
+            /* Make sure there is a field there. */
+            if (*it == ',') {
+                ++it;
+                field = it;
+            } else {
+                present = false;
             }
+        }
 
-            next_field();
+        template <typename FIELD, typename RING_IT>
+        static bool scan_field(RING_IT & it, RING_IT & field, bool & present, typename FIELD::value_type & target) noexcept {
+            if (!FIELD::decode(field, present, target))
+                return false;
+            next_field(it, field, present);
+            return true;
         }
 
-        result = true;
+        template <typename RING_IT>
+        static bool scan(RING_IT it, RING_IT, typename FIELDS::value_type &... targets) noexcept {
+            auto field = it;
+            bool present = true;
+            return (scan_field<FIELDS>(it, field, present, targets) && ...);
+        }
 
-        parse_error:
-        va_end(ap);
-        return result;
-    }
+        // the same with the targets tied together
+        template <typename RING_IT>
+        static bool scan(RING_IT it, RING_IT, std::tuple<typename FIELDS::value_type &...> targets) noexcept {
+            return scan_tied(it, targets, std::index_sequence_for<FIELDS...> {});
+        }
 
-    template <typename RING_IT>
-    bool minmea_parse_rmc(struct minmea_sentence_rmc *frame, RING_IT it, RING_IT end) noexcept
+    private:
+        template <typename RING_IT, size_t... I>
+        static bool scan_tied(RING_IT it, std::tuple<typename FIELDS::value_type &...> & targets, std::index_sequence<I...>) noexcept {
+            auto field = it;
+            bool present = true;
+            return (scan_field<FIELDS>(it, field, present, std::get<I>(targets)) && ...);
+        }
+    };
+
+    using minmea_rmc_schema = minmea_schema<minmea_field::time, minmea_field::character,
+                                            minmea_field::fixed, minmea_field::direction,
+                                            minmea_field::fixed, minmea_field::direction,
+                                            minmea_field::fixed, minmea_field::fixed, minmea_field::date,
+                                            minmea_field::fixed, minmea_field::direction>;
+
+    using minmea_gga_schema = minmea_schema<minmea_field::time,
+                                            minmea_field::fixed, minmea_field::direction,
+                                            minmea_field::fixed, minmea_field::direction,
+                                            minmea_field::integer, minmea_field::integer, minmea_field::fixed,
+                                            minmea_field::fixed, minmea_field::character,
+                                            minmea_field::fixed, minmea_field::character,
+                                            minmea_field::fixed>;
+
+    using minmea_gll_schema = minmea_schema<minmea_field::fixed, minmea_field::direction,
+                                            minmea_field::fixed, minmea_field::direction,
+                                            minmea_field::time, minmea_field::character, minmea_field::character>;
+
+    using minmea_gsa_schema = minmea_schema<minmea_field::character, minmea_field::integer,
+                                            minmea_field::integer, minmea_field::integer, minmea_field::integer,
+                                            minmea_field::integer, minmea_field::integer, minmea_field::integer,
+                                            minmea_field::integer, minmea_field::integer, minmea_field::integer,
+                                            minmea_field::integer, minmea_field::integer, minmea_field::integer,
+                                            minmea_field::fixed, minmea_field::fixed, minmea_field::fixed>;
+
+    using minmea_gsv_schema = minmea_schema<minmea_field::integer, minmea_field::integer, minmea_field::integer,
+                                            minmea_field::integer, minmea_field::integer, minmea_field::integer, minmea_field::integer,
+                                            minmea_field::integer, minmea_field::integer, minmea_field::integer, minmea_field::integer,
+                                            minmea_field::integer, minmea_field::integer, minmea_field::integer, minmea_field::integer,
+                                            minmea_field::integer, minmea_field::integer, minmea_field::integer, minmea_field::integer>;
+
+    using minmea_vtg_schema = minmea_schema<minmea_field::fixed, minmea_field::character,
+                                            minmea_field::fixed, minmea_field::character,
+                                            minmea_field::fixed, minmea_field::character,
+                                            minmea_field::fixed, minmea_field::character,
+                                            minmea_field::character>;
+
+    using minmea_zda_schema = minmea_schema<minmea_field::time,
+                                            minmea_field::integer, minmea_field::integer, minmea_field::integer,
+                                            minmea_field::integer, minmea_field::integer>;
+
+    // How the fields of a sentence land in its frame: the schema, the targets of its fields, which are members of the
+    // frame or extras such as the hemisphere of a coordinate, and what is left to do once all of them are decoded.
+    template <class FRAME>
+    struct sentence_layout;
+
+    template <>
+    struct sentence_layout<minmea_sentence_rmc>
+    {
+        using schema = minmea_rmc_schema;
+
+        struct extras {
+            char validity;
+            int latitude_direction;
+            int longitude_direction;
+            int variation_direction;
+        };
+
+        static auto targets(minmea_sentence_rmc & frame, extras & e) noexcept {
+            return std::tie(frame.time,
+                            e.validity,
+                            frame.latitude, e.latitude_direction,
+                            frame.longitude, e.longitude_direction,
+                            frame.speed,
+                            frame.course,
+                            frame.date,
+                            frame.variation, e.variation_direction);
+        }
+
+        static bool finish(minmea_sentence_rmc & frame, extras const & e) noexcept {
+            frame.valid = (e.validity == 'A');
+            frame.latitude.value *= e.latitude_direction;
+            frame.longitude.value *= e.longitude_direction;
+            frame.variation.value *= e.variation_direction;
+            return true;
+        }
+    };
+
+    template <>
+    struct sentence_layout<minmea_sentence_gga>
+    {
+        using schema = minmea_gga_schema;
+
+        struct extras {
+            int latitude_direction;
+            int longitude_direction;
+        };
+
+        static auto targets(minmea_sentence_gga & frame, extras & e) noexcept {
+            return std::tie(frame.time,
+                            frame.latitude, e.latitude_direction,
+                            frame.longitude, e.longitude_direction,
+                            frame.fix_quality, frame.satellites_tracked, frame.hdop,
+                            frame.altitude, frame.altitude_units,
+                            frame.height, frame.height_units,
+                            frame.dgps_age);
+        }
+
+        static bool finish(minmea_sentence_gga & frame, extras const & e) noexcept {
+            frame.latitude.value *= e.latitude_direction;
+            frame.longitude.value *= e.longitude_direction;
+            return true;
+        }
+    };
+
+    template <>
+    struct sentence_layout<minmea_sentence_gll>
+    {
+        using schema = minmea_gll_schema;
+
+        struct extras {
+            int latitude_direction;
+            int longitude_direction;
+        };
+
+        static auto targets(minmea_sentence_gll & frame, extras & e) noexcept {
+            return std::tie(frame.latitude, e.latitude_direction,
+                            frame.longitude, e.longitude_direction,
+                            frame.time, frame.status, frame.mode);
+        }
+
+        static bool finish(minmea_sentence_gll & frame, extras const & e) noexcept {
+            frame.latitude.value *= e.latitude_direction;
+            frame.longitude.value *= e.longitude_direction;
+            return true;
+        }
+    };
+
+    template <>
+    struct sentence_layout<minmea_sentence_gsa>
+    {
+        using schema = minmea_gsa_schema;
+
+        struct extras {};
+
+        static auto targets(minmea_sentence_gsa & frame, extras &) noexcept {
+            int * const sats = frame.sats;
+            return std::tie(frame.mode, frame.fix_type,
+                            sats[0], sats[1], sats[2], sats[3], sats[4], sats[5],
+                            sats[6], sats[7], sats[8], sats[9], sats[10], sats[11],
+                            frame.pdop, frame.hdop, frame.vdop);
+        }
+
+        static bool finish(minmea_sentence_gsa &, extras const &) noexcept {
+            return true;
+        }
+    };
+
+    template <>
+    struct sentence_layout<minmea_sentence_gsv>
+    {
+        using schema = minmea_gsv_schema;
+
+        struct extras {};
+
+        static auto targets(minmea_sentence_gsv & frame, extras &) noexcept {
+            minmea_sat_info * const sats = frame.sats;
+            return std::tie(frame.total_msgs, frame.msg_nr, frame.total_sats,
+                            sats[0].nr, sats[0].elevation, sats[0].azimuth, sats[0].snr,
+                            sats[1].nr, sats[1].elevation, sats[1].azimuth, sats[1].snr,
+                            sats[2].nr, sats[2].elevation, sats[2].azimuth, sats[2].snr,
+                            sats[3].nr, sats[3].elevation, sats[3].azimuth, sats[3].snr);
+        }
+
+        static bool finish(minmea_sentence_gsv &, extras const &) noexcept {
+            return true;
+        }
+    };
+
+    template <>
+    struct sentence_layout<minmea_sentence_vtg>
     {
-        char validity;
-        int latitude_direction;
-        int longitude_direction;
-        int variation_direction;
-        if (!minmea_scan(it, end, "TcfdfdffDfd",
-                         &frame->time,
-                         &validity,
-                         &frame->latitude, &latitude_direction,
-                         &frame->longitude, &longitude_direction,
-                         &frame->speed,
-                         &frame->course,
-                         &frame->date,
-                         &frame->variation, &variation_direction))
-            return false;
-
-        frame->valid = (validity == 'A');
-        frame->latitude.value *= latitude_direction;
-        frame->longitude.value *= longitude_direction;
-        frame->variation.value *= variation_direction;
-
-        return true;
+        using schema = minmea_vtg_schema;
+
+        struct extras {
+            char c_true, c_magnetic, c_knots, c_kph;
+        };
+
+        static auto targets(minmea_sentence_vtg & frame, extras & e) noexcept {
+            return std::tie(frame.true_track_degrees, e.c_true,
+                            frame.magnetic_track_degrees, e.c_magnetic,
+                            frame.speed_knots, e.c_knots,
+                            frame.speed_kph, e.c_kph,
+                            frame.faa_mode);
+        }
+
+        // the unit fields are either empty or tell the units
+        static bool finish(minmea_sentence_vtg &, extras const & e) noexcept {
+            return (!e.c_true || e.c_true == 'T') && (!e.c_magnetic || e.c_magnetic == 'M') &&
+                   (!e.c_knots || e.c_knots == 'N') && (!e.c_kph || e.c_kph == 'K');
+        }
+    };
+
+    template <>
+    struct sentence_layout<minmea_sentence_zda>
+    {
+        using schema = minmea_zda_schema;
+
+        struct extras {};
+
+        static auto targets(minmea_sentence_zda & frame, extras &) noexcept {
+            return std::tie(frame.time,
+                            frame.date.day, frame.date.month, frame.date.year,
+                            frame.hour_offset, frame.minute_offset);
+        }
+
+        static bool finish(minmea_sentence_zda & frame, extras const &) noexcept {
+            // the local zone, as upstream checks it
+            return (frame.hour_offset >= -13) && (frame.hour_offset <= 13) &&
+                   (frame.minute_offset >= 0) && (frame.minute_offset <= 59);
+        }
+    };
+
+    // decodes the fields of a sentence into its frame as its layout says
+    template <class FRAME, typename RING_IT>
+    bool minmea_parse_layout(FRAME *frame, RING_IT it, RING_IT end) noexcept
+    {
+        using layout = sentence_layout<FRAME>;
+        typename layout::extras extras;
+        return layout::schema::scan(it, end, layout::targets(*frame, extras)) && layout::finish(*frame, extras);
     }
+
+    template <typename RING_IT>
+    bool minmea_parse_rmc(struct minmea_sentence_rmc *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_layout(frame, it, end); }
+    template <typename RING_IT>
+    bool minmea_parse_gga(struct minmea_sentence_gga *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_layout(frame, it, end); }
+    template <typename RING_IT>
+    bool minmea_parse_gll(struct minmea_sentence_gll *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_layout(frame, it, end); }
+    template <typename RING_IT>
+    bool minmea_parse_gsa(struct minmea_sentence_gsa *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_layout(frame, it, end); }
+    template <typename RING_IT>
+    bool minmea_parse_gsv(struct minmea_sentence_gsv *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_layout(frame, it, end); }
+    template <typename RING_IT>
+    bool minmea_parse_vtg(struct minmea_sentence_vtg *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_layout(frame, it, end); }
+    template <typename RING_IT>
+    bool minmea_parse_zda(struct minmea_sentence_zda *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_layout(frame, it, end); }
+
+    // one name for all the sentence parsers, to be picked by the frame type
+    template <typename RING_IT>
+    bool minmea_parse(struct minmea_sentence_rmc *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_rmc(frame, it, end); }
+    template <typename RING_IT>
+    bool minmea_parse(struct minmea_sentence_gga *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_gga(frame, it, end); }
+    template <typename RING_IT>
+    bool minmea_parse(struct minmea_sentence_gll *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_gll(frame, it, end); }
+    template <typename RING_IT>
+    bool minmea_parse(struct minmea_sentence_gsa *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_gsa(frame, it, end); }
+    template <typename RING_IT>
+    bool minmea_parse(struct minmea_sentence_gsv *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_gsv(frame, it, end); }
+    template <typename RING_IT>
+    bool minmea_parse(struct minmea_sentence_vtg *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_vtg(frame, it, end); }
+    template <typename RING_IT>
+    bool minmea_parse(struct minmea_sentence_zda *frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_zda(frame, it, end); }
 }
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <fields.h>
+#include <stats.h>
+#include <states.h>
+
+// Compile-time options of a machine, given as its third template parameter. A traits type provides them all; deriving
+// from default_traits and overriding some of them is the easiest way to write one.
+
+namespace serial
+{
+    using state_histogram = cycle_histogram<state_count>;
+
+    // what fill_data() does with more bytes than the ring has room for
+    enum class overflow_policy : uint8_t
+    {
+        drop_oldest, // makes room at the expense of the unparsed bytes and a sentence in flight
+        drop_newest, // takes what fits
+        block        // runs the states to make room as it goes, dropping the oldest only if they can not
+    };
+
+    struct default_traits
+    {
+        using stats_type = no_stats;       // the counters, parser_stats to have them
+        using profiler_type = no_profiler; // the timing of the states, state_histogram to have it
+        using latency_type = no_latency;   // the times of the sentences, latency_probe to have them
+        static constexpr overflow_policy overflow = overflow_policy::drop_oldest;
+        static constexpr uint16_t max_sentence_size = serial::max_sentence_size; // longer ones are dropped, see next_sentence()
+        static constexpr uint16_t rmc_fields = rmc_field::all; // fewer for a callback taking rmc_subset<rmc_fields>
+    };
+
+    struct counting_traits : default_traits
+    {
+        using stats_type = parser_stats;
+    };
+}
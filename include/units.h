@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <sentence.h>
+#include <span.h>
+
+// Frames in units to compute with: decimal degrees, metres per second and a time point, instead of the fixed-point
+// fields and the DDMM.mmmm coordinates of NMEA. The conversion multiplies by reciprocal scales from a table and has no
+// branches, so that a batch of frames converts in a loop the compiler can vectorize. A callback taking rmc_fix instead
+// of minmea_sentence_rmc has the fields decoded straight into it, with no integer frame in between.
+
+namespace serial
+{
+    using fix_time = std::chrono::time_point<std::chrono::system_clock, std::chrono::microseconds>;
+
+    struct rmc_fix
+    {
+        fix_time time;    // UTC, the epoch if the date or the time is empty
+        bool valid;
+        double latitude;  // decimal degrees, south negative
+        double longitude; // decimal degrees, west negative
+        float speed;      // m/s
+        float course;     // degrees true
+        float variation;  // degrees, west negative
+    };
+
+    // the frame type a callback can take instead of the decoded one, void if there is none
+    template <class FRAME>
+    struct typed_frame
+    {
+        using type = void;
+    };
+
+    template <>
+    struct typed_frame<minmea_sentence_rmc>
+    {
+        using type = rmc_fix;
+    };
+
+    template <class FRAME>
+    using typed_frame_t = typename typed_frame<FRAME>::type;
+
+    template <> inline constexpr sentence_id sentence_id_of<rmc_fix> = sentence_id::rmc;
+
+    // 1 / scale by the position of the highest bit of the scale, which tells the powers of ten apart; 0 for the scale 0
+    // of an empty field, whose value is 0 as well
+    inline constexpr double reciprocal_scales[32] = {1e0, 0, 0, 1e-1, 0, 0, 1e-2, 0, 0, 1e-3, 0, 0, 0, 1e-4, 0, 0,
+                                                     1e-5, 0, 0, 1e-6, 0, 0, 0, 1e-7, 0, 0, 1e-8, 0, 0, 1e-9, 0, 0};
+
+    constexpr double metres_per_second_per_knot = 1852.0 / 3600.0;
+
+    [[nodiscard]] constexpr double to_double(minmea_float f) noexcept
+    {
+        return f.value * reciprocal_scales[31 - __builtin_clz(uint32_t(f.scale) | 1u)];
+    }
+
+    [[nodiscard]] inline double to_degrees(minmea_float f) noexcept
+    {
+        auto const raw = to_double(f);
+        auto const degrees = static_cast<double>(static_cast<int_least32_t>(raw * 0.01));
+        return degrees + (raw - degrees * 100.0) * (1.0 / 60.0);
+    }
+
+    [[nodiscard]] inline float knots_to_mps(minmea_float f) noexcept
+    {
+        return static_cast<float>(to_double(f) * metres_per_second_per_knot);
+    }
+
+    // days since 1970-01-01 of a date of the proleptic Gregorian calendar
+    [[nodiscard]] constexpr int_least32_t days_from_civil(int_least32_t y, int_least32_t m, int_least32_t d) noexcept
+    {
+        y -= m <= 2;
+        auto const era = (y >= 0 ? y : y - 399) / 400;
+        auto const yoe = y - era * 400;
+        auto const doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        auto const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+    // the two-digit years of NMEA are taken as 20YY
+    [[nodiscard]] constexpr fix_time to_time_point(minmea_date const & date, minmea_time const & time) noexcept
+    {
+        auto const days = days_from_civil(2000 + date.year, date.month, date.day);
+        auto const seconds = ((int_least64_t(days) * 24 + time.hours) * 60 + time.minutes) * 60 + time.seconds;
+        auto const empty = (date.year < 0) | (time.hours < 0);
+        return fix_time(std::chrono::microseconds(empty ? 0 : seconds * 1000000 + time.microseconds));
+    }
+
+    [[nodiscard]] inline rmc_fix to_fix(minmea_sentence_rmc const & rmc) noexcept
+    {
+        return rmc_fix {to_time_point(rmc.date, rmc.time), rmc.valid, to_degrees(rmc.latitude), to_degrees(rmc.longitude),
+                        knots_to_mps(rmc.speed), static_cast<float>(to_double(rmc.course)),
+                        static_cast<float>(to_double(rmc.variation))};
+    }
+
+    // converts as many frames as both spans have room for
+    inline size_t to_fixes(span<minmea_sentence_rmc const> frames, span<rmc_fix> fixes) noexcept
+    {
+        auto const n = std::min(frames.size(), fixes.size());
+        for (size_t i = 0; i < n; ++i)
+        {
+            fixes[i] = to_fix(frames[i]);
+        }
+        return n;
+    }
+
+    // Field decoders that convert as they go, for the schema of rmc_fix. The integer form of a field lives in a register
+    // for as long as the conversion takes.
+    namespace minmea_field
+    {
+        struct degrees // 'f' of DDDMM.mmmm, in decimal degrees
+        {
+            using value_type = double;
+
+            template <typename RING_IT>
+            static bool decode(RING_IT field, bool present, double & value) noexcept {
+                minmea_float f;
+                if (!fixed::decode(field, present, f))
+                    return false;
+                value = to_degrees(f);
+                return true;
+            }
+        };
+
+        struct knots // 'f' of a speed in knots, in m/s
+        {
+            using value_type = float;
+
+            template <typename RING_IT>
+            static bool decode(RING_IT field, bool present, float & value) noexcept {
+                minmea_float f;
+                if (!fixed::decode(field, present, f))
+                    return false;
+                value = knots_to_mps(f);
+                return true;
+            }
+        };
+
+        struct real // 'f' as it is
+        {
+            using value_type = float;
+
+            template <typename RING_IT>
+            static bool decode(RING_IT field, bool present, float & value) noexcept {
+                minmea_float f;
+                if (!fixed::decode(field, present, f))
+                    return false;
+                value = static_cast<float>(to_double(f));
+                return true;
+            }
+        };
+    }
+
+    using rmc_fix_schema = minmea_schema<minmea_field::time, minmea_field::character,
+                                         minmea_field::degrees, minmea_field::direction,
+                                         minmea_field::degrees, minmea_field::direction,
+                                         minmea_field::knots, minmea_field::real, minmea_field::date,
+                                         minmea_field::real, minmea_field::direction>;
+
+    template <>
+    struct sentence_layout<rmc_fix>
+    {
+        using schema = rmc_fix_schema;
+
+        struct extras {
+            minmea_time time;
+            minmea_date date;
+            char validity;
+            int latitude_direction;
+            int longitude_direction;
+            int variation_direction;
+        };
+
+        static auto targets(rmc_fix & frame, extras & e) noexcept {
+            return std::tie(e.time,
+                            e.validity,
+                            frame.latitude, e.latitude_direction,
+                            frame.longitude, e.longitude_direction,
+                            frame.speed,
+                            frame.course,
+                            e.date,
+                            frame.variation, e.variation_direction);
+        }
+
+        static bool finish(rmc_fix & frame, extras const & e) noexcept {
+            frame.time = to_time_point(e.date, e.time);
+            frame.valid = (e.validity == 'A');
+            frame.latitude *= e.latitude_direction;
+            frame.longitude *= e.longitude_direction;
+            frame.variation *= static_cast<float>(e.variation_direction);
+            return true;
+        }
+    };
+
+    template <typename RING_IT>
+    bool minmea_parse(rmc_fix * frame, RING_IT it, RING_IT end) noexcept { return minmea_parse_layout(frame, it, end); }
+}
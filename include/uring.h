@@ -0,0 +1,263 @@
+#pragma once
+
+#if !defined(__linux__)
+#error "uring.h needs Linux"
+#endif
+
+#include <machine.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Reading of many ttys, pipes and files by one thread through io_uring. Every source has a machine and a buffer of its
+// own among the buffers registered with the kernel once; a fixed read per source is kept in flight, the kernel fills the
+// buffer in and the machine parses it in place with its span parse, so there is neither a read() call per chunk nor a
+// copy of the bytes on the way. The ring is set up with the raw system calls, liburing is not needed.
+
+namespace serial
+{
+    template <size_t bs, class Callback, class Traits = default_traits>
+    class uring_reader
+    {
+        struct source
+        {
+            serial::machine<bs, Callback, Traits> parser;
+            int fd;
+            int error = 0;      // the errno a read ended with
+            bool reading = true; // until the end of file or an error
+
+            source(int fd, Callback callback) : parser(std::move(callback)), fd(fd) {}
+        };
+
+        int ring_ = -1;
+        size_t max_sources_;
+        std::vector<std::unique_ptr<source>> sources_;
+        unsigned to_submit_ = 0;
+
+        void * rings_ = MAP_FAILED; // the submission and completion rings mapped as one
+        size_t rings_size_ = 0;
+        io_uring_sqe * sqes_ = static_cast<io_uring_sqe *>(MAP_FAILED);
+        size_t sqes_size_ = 0;
+        char * buffers_ = static_cast<char *>(MAP_FAILED);
+
+        unsigned * sq_tail_ = nullptr;
+        unsigned sq_mask_ = 0;
+        unsigned * sq_array_ = nullptr;
+        unsigned * cq_head_ = nullptr;
+        unsigned * cq_tail_ = nullptr;
+        unsigned cq_mask_ = 0;
+        io_uring_cqe * cqes_ = nullptr;
+
+        template <class T>
+        T * at(size_t offset) const noexcept
+        {
+            return reinterpret_cast<T *>(static_cast<char *>(rings_) + offset);
+        }
+
+        bool set_up(unsigned entries) noexcept
+        {
+            io_uring_params params {};
+            ring_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+            if (ring_ < 0 || !(params.features & IORING_FEAT_SINGLE_MMAP))
+            {
+                return false;
+            }
+            rings_size_ = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                                   params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+            rings_ = ::mmap(nullptr, rings_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQ_RING);
+            sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+            sqes_ = static_cast<io_uring_sqe *>(::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                                       ring_, IORING_OFF_SQES));
+            buffers_ = static_cast<char *>(::mmap(nullptr, max_sources_ * bs, PROT_READ | PROT_WRITE,
+                                                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (rings_ == MAP_FAILED || sqes_ == MAP_FAILED || buffers_ == MAP_FAILED)
+            {
+                return false;
+            }
+            sq_tail_ = at<unsigned>(params.sq_off.tail);
+            sq_mask_ = *at<unsigned>(params.sq_off.ring_mask);
+            sq_array_ = at<unsigned>(params.sq_off.array);
+            cq_head_ = at<unsigned>(params.cq_off.head);
+            cq_tail_ = at<unsigned>(params.cq_off.tail);
+            cq_mask_ = *at<unsigned>(params.cq_off.ring_mask);
+            cqes_ = at<io_uring_cqe>(params.cq_off.cqes);
+
+            iovec buffers {buffers_, max_sources_ * bs}; // one registration for all of the sources
+            return ::syscall(__NR_io_uring_register, ring_, IORING_REGISTER_BUFFERS, &buffers, 1) == 0;
+        }
+
+        [[nodiscard]] char * buffer(size_t s) const noexcept
+        {
+            return buffers_ + s * bs;
+        }
+
+        // one read in flight per source, so the submission ring never fills
+        void queue_read(size_t s) noexcept
+        {
+            auto const tail = *sq_tail_;
+            auto const index = tail & sq_mask_;
+            auto & sqe = sqes_[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READ_FIXED;
+            sqe.fd = sources_[s]->fd;
+            sqe.addr = reinterpret_cast<uint64_t>(buffer(s));
+            sqe.len = bs;
+            sqe.off = static_cast<uint64_t>(-1); // the file position, for ttys and pipes too
+            sqe.buf_index = 0;
+            sqe.user_data = s;
+            sq_array_[index] = index;
+            __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+            ++to_submit_;
+        }
+
+        void complete(size_t s, int result) noexcept
+        {
+            auto & source = *sources_[s];
+            if (result > 0)
+            {
+                source.parser.parse(buffer(s), static_cast<size_t>(result));
+                queue_read(s);
+            } else if (result == -EAGAIN || result == -EINTR)
+            {
+                queue_read(s);
+            } else
+            {
+                source.error = -result;
+                source.reading = false;
+            }
+        }
+
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        // is_open() tells if the kernel has io_uring
+        explicit uring_reader(size_t max_sources) : max_sources_(std::max<size_t>(max_sources, 1))
+        {
+            if (!set_up(static_cast<unsigned>(max_sources_)))
+            {
+                close();
+            }
+            sources_.reserve(max_sources_);
+        }
+
+        uring_reader(uring_reader const &) = delete;
+        uring_reader & operator=(uring_reader const &) = delete;
+
+        ~uring_reader()
+        {
+            close();
+        }
+
+        [[nodiscard]] bool is_open() const noexcept
+        {
+            return ring_ >= 0;
+        }
+
+        // Starts reading the descriptor, which stays the caller's to close after the reading ends; blocking descriptors
+        // are best, a non-blocking one with no bytes ready is tried again at every run(). npos if there is no room.
+        size_t add(int fd, Callback callback = Callback {})
+        {
+            if (!is_open() || sources_.size() == max_sources_)
+            {
+                return npos;
+            }
+            sources_.push_back(std::make_unique<source>(fd, std::move(callback)));
+            queue_read(sources_.size() - 1);
+            return sources_.size() - 1;
+        }
+
+        // Submits the reads queued, waits for a completion at least if asked to and there are reads in flight, and
+        // parses all of the completed ones. The number of reads completed, or -errno if io_uring_enter() failed.
+        int run(bool wait = true) noexcept
+        {
+            if (!is_open())
+            {
+                return -EBADF;
+            }
+            auto const min_complete = (wait && reading() != 0) ? 1u : 0u;
+            if (to_submit_ != 0 || min_complete != 0)
+            {
+                auto const entered = ::syscall(__NR_io_uring_enter, ring_, to_submit_, min_complete,
+                                               min_complete ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+                if (entered < 0)
+                {
+                    return (errno == EINTR) ? 0 : -errno;
+                }
+                to_submit_ -= static_cast<unsigned>(entered);
+            }
+            auto head = *cq_head_;
+            auto const tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            int completed = 0;
+            for (; head != tail; ++head, ++completed)
+            {
+                auto const & cqe = cqes_[head & cq_mask_];
+                complete(static_cast<size_t>(cqe.user_data), cqe.res);
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+            return completed;
+        }
+
+        // the sources still being read
+        [[nodiscard]] size_t reading() const noexcept
+        {
+            return static_cast<size_t>(std::count_if(sources_.begin(), sources_.end(), [](auto const & s) { return s->reading; }));
+        }
+
+        [[nodiscard]] size_t sources() const noexcept
+        {
+            return sources_.size();
+        }
+
+        [[nodiscard]] bool reading(size_t s) const noexcept
+        {
+            return sources_[s]->reading;
+        }
+
+        // the errno the reading of a source ended with, 0 for the end of file
+        [[nodiscard]] int error(size_t s) const noexcept
+        {
+            return sources_[s]->error;
+        }
+
+        [[nodiscard]] machine<bs, Callback, Traits> const & get_machine(size_t s) const noexcept
+        {
+            return sources_[s]->parser;
+        }
+
+        [[nodiscard]] Callback & get_callback(size_t s) noexcept
+        {
+            return sources_[s]->parser.get_callback();
+        }
+
+    private:
+        void close() noexcept
+        {
+            if (ring_ >= 0)
+            {
+                ::close(ring_); // cancels the reads in flight, the kernel holds on to the registered pages until they end
+                ring_ = -1;
+            }
+            if (buffers_ != MAP_FAILED)
+            {
+                ::munmap(buffers_, max_sources_ * bs);
+                buffers_ = static_cast<char *>(MAP_FAILED);
+            }
+            if (sqes_ != MAP_FAILED)
+            {
+                ::munmap(sqes_, sqes_size_);
+                sqes_ = static_cast<io_uring_sqe *>(MAP_FAILED);
+            }
+            if (rings_ != MAP_FAILED)
+            {
+                ::munmap(rings_, rings_size_);
+                rings_ = MAP_FAILED;
+            }
+        }
+    };
+}
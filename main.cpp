@@ -1,4 +1,5 @@
 #include <machine.h>
+#include <mapped.h>
 #include <random>
 #include <iomanip>
 
@@ -14,8 +15,23 @@ struct message_callback
     }
 };
 
-int main()
+int main(int argc, char * argv[])
 {
+    if (argc > 1) // a recorded file, read in place
+    {
+        serial::mapped_log const log(argv[1]);
+        if (!log.is_open())
+        {
+            std::cerr << "Can not open " << argv[1] << '\n';
+            return 1;
+        }
+        for (auto const & rmc : log.frames())
+        {
+            message_callback::callback(rmc);
+        }
+        return 0;
+    }
+
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_int_distribution<> dis (10,100);
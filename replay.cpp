@@ -0,0 +1,224 @@
+#include <machine.h>
+#include <replay.h>
+#include <cstdlib>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records a byte stream with the time and size of every read, and replays it into machines as a receiver would deliver
+// it, for load tests with real captures:
+//   replay record <capture> [device]             reads the device, standard input by default, up to its end
+//   replay play <capture> [speed [machines [mode]]]
+//       speed is 1 for the recorded pace, N, or max; 1 machine by default, each on a thread of its own. The mode is span
+//       for parse() straight from the chunks, the default, or ring for fill_data() and parse_all(), whose overflow is
+//       counted in the dropped bytes.
+
+namespace
+{
+    constexpr size_t ring_size = 1024;
+
+    struct timed_callback // notes the latency of every frame
+    {
+        serial::replayer * replay;
+        void operator()(serial::any_sentence const &) const
+        {
+            replay->delivered();
+        }
+    };
+
+    using replay_machine = serial::machine<ring_size, timed_callback, serial::counting_traits>;
+
+    int record(char const * path, char const * device)
+    {
+        auto const fd = device ? ::open(device, O_RDONLY | O_NOCTTY) : STDIN_FILENO;
+        if (fd < 0)
+        {
+            std::cerr << "Can not open " << device << '\n';
+            return 1;
+        }
+        serial::capture_writer out(path);
+        if (!out.is_open())
+        {
+            std::cerr << "Can not create " << path << '\n';
+            return 1;
+        }
+        char buffer[4096];
+        size_t bytes = 0, chunks = 0;
+        for (;;)
+        {
+            auto const n = ::read(fd, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                break;
+            }
+            if (!out.record(buffer, static_cast<size_t>(n)))
+            {
+                std::cerr << "Can not write " << path << '\n';
+                return 1;
+            }
+            bytes += static_cast<size_t>(n);
+            ++chunks;
+        }
+        std::cerr << bytes << " bytes in " << chunks << " chunks\n";
+        return 0;
+    }
+
+    double micros(std::chrono::nanoseconds ns)
+    {
+        return double(ns.count()) / 1000.0;
+    }
+
+    enum class feed_mode
+    {
+        span, // parse() straight from the chunk
+        ring  // fill_data() and parse_all(), where a chunk larger than the ring room overflows
+    };
+
+    struct machine_run
+    {
+        serial::replay_report report;
+        serial::parser_stats stats;
+    };
+
+    // a machine fed on its own thread, with its own pacing, so that its latencies are its own
+    machine_run run_machine(serial::capture const & in, double speed, feed_mode mode)
+    {
+        serial::replayer replay(in.chunks());
+        replay_machine m(timed_callback {&replay});
+        machine_run run;
+        if (mode == feed_mode::span)
+        {
+            run.report = replay.run(speed, [&m](char const * data, size_t n) { m.parse(data, n); });
+        } else
+        {
+            run.report = replay.run(speed, [&m](char const * data, size_t n)
+            {
+                m.fill_data(data, n);
+                m.parse_all();
+            });
+        }
+        run.stats = m.stats();
+        return run;
+    }
+
+    void print_latencies(serial::replay_report const & report)
+    {
+        std::cout << "latency us p50 " << micros(report.percentile(0.5)) << " p90 " << micros(report.percentile(0.9))
+                  << " p99 " << micros(report.percentile(0.99)) << " p99.9 " << micros(report.percentile(0.999))
+                  << " max " << micros(report.percentile(1)) << '\n';
+    }
+
+    int play(char const * path, double speed, size_t machines, feed_mode mode)
+    {
+        serial::capture const in(path);
+        if (!in.is_open())
+        {
+            std::cerr << "Not a capture: " << path << '\n';
+            return 1;
+        }
+        std::vector<machine_run> runs(machines);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < machines; ++i)
+        {
+            threads.emplace_back([&in, &runs, i, speed, mode] { runs[i] = run_machine(in, speed, mode); });
+        }
+        for (auto & thread : threads)
+        {
+            thread.join();
+        }
+
+        serial::replay_report all;
+        serial::parser_stats total;
+        for (auto const & run : runs)
+        {
+            all.bytes += run.report.bytes;
+            all.elapsed = std::max(all.elapsed, run.report.elapsed);
+            all.behind = std::max(all.behind, run.report.behind);
+            all.latencies.insert(all.latencies.end(), run.report.latencies.begin(), run.report.latencies.end());
+            auto const & s = run.stats;
+            total.checksum_failures += s.checksum_failures;
+            total.resyncs += s.resyncs;
+            total.malformed += s.malformed;
+            total.field_errors += s.field_errors;
+            total.ring_full_events += s.ring_full_events;
+            total.dropped_bytes += s.dropped_bytes;
+        }
+        std::sort(all.latencies.begin(), all.latencies.end());
+
+        auto const seconds = std::max(double(all.elapsed.count()) / 1e9, 1e-9);
+        std::cout << std::fixed << std::setprecision(3)
+                  << "chunks " << runs.front().report.chunks << ", bytes " << runs.front().report.bytes << " per machine, "
+                  << machines << " machines on a thread each, " << ((mode == feed_mode::span) ? "span parse" : "ring") << '\n'
+                  << "elapsed " << seconds << " s, capture " << double(in.duration().count()) / 1e9 << " s, "
+                  << "behind at most " << micros(all.behind) << " us\n"
+                  << "throughput " << double(all.bytes) / seconds / 1e6 << " MB/s, "
+                  << double(all.latencies.size()) / seconds << " sentences/s, " << all.latencies.size() << " sentences\n";
+        print_latencies(all);
+        if (machines > 1)
+        {
+            for (size_t i = 0; i < machines; ++i)
+            {
+                std::cout << "machine " << i << ": " << runs[i].report.latencies.size() << " sentences, ";
+                print_latencies(runs[i].report);
+            }
+        }
+        std::cout << "dropped bytes " << total.dropped_bytes << ", ring full " << total.ring_full_events
+                  << ", checksum failures " << total.checksum_failures << ", resyncs " << total.resyncs
+                  << ", malformed " << total.malformed << ", field errors " << total.field_errors << '\n';
+        return 0;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    auto const usage = [argv]
+    {
+        std::cerr << "Usage: " << argv[0] << " record <capture> [device]\n"
+                  << "       " << argv[0] << " play <capture> [1 | N | max [machines [span | ring]]]\n";
+        return 2;
+    };
+    std::string const command = (argc > 2) ? argv[1] : "";
+    if (command == "record")
+    {
+        return record(argv[2], (argc > 3) ? argv[3] : nullptr);
+    }
+    if (command == "play")
+    {
+        std::string const speed = (argc > 3) ? argv[3] : "1";
+        double factor = 0.0; // as fast as it goes
+        if (speed != "max")
+        {
+            char * end = nullptr;
+            factor = std::strtod(speed.c_str(), &end);
+            if (end == speed.c_str() || *end || !(factor > 0.0))
+            {
+                std::cerr << "Bad speed " << speed << '\n';
+                return usage();
+            }
+        }
+        unsigned long machines = 1;
+        if (argc > 4)
+        {
+            char * end = nullptr;
+            machines = std::strtoul(argv[4], &end, 10);
+            if (end == argv[4] || *end || !machines)
+            {
+                std::cerr << "Bad machine count " << argv[4] << '\n';
+                return usage();
+            }
+        }
+        std::string const mode = (argc > 5) ? argv[5] : "span";
+        if (mode != "span" && mode != "ring")
+        {
+            std::cerr << "Unknown mode " << mode << '\n';
+            return usage();
+        }
+        return play(argv[2], factor, machines, (mode == "ring") ? feed_mode::ring : feed_mode::span);
+    }
+    return usage();
+}
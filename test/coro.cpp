@@ -0,0 +1,87 @@
+#define BOOST_TEST_MODULE coro_test_module
+#include <boost/test/unit_test.hpp>
+#include <coro.h>
+#include <vector>
+
+// the coroutine front end, built as C++20 on its own
+
+// counts the heap allocations; out of line, so that GCC does not see free() called on what operator new returned
+std::size_t allocations = 0;
+[[gnu::noinline]] void * operator new(std::size_t s)
+{
+    ++allocations;
+    if (void * p = std::malloc(s))
+        return p;
+    throw std::bad_alloc();
+}
+[[gnu::noinline]] void operator delete(void * p) noexcept
+{
+    std::free(p);
+}
+[[gnu::noinline]] void operator delete(void * p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+char const stream[] = "$GPRMC,081836.000,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*75\x0D\x0A"
+                      "BROKEN,072635.327,BROKEN.406,N,01324.297,E,383.9,000.0,140220,000.0,W*73\x0D\x0A"
+                      "$GPRMC,225446,A,4916.45,N,12311.12,W,000.5,054.7,191119,020.3,E*6D\x0D\x0A"
+                      "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\x0D\x0A"
+                      "$GPRMC,072640.327,A,5230.331,N,01324.153,E,000.0,000.0,140220,000.0,W*78\x0D\x0A";
+
+using rmc_machine = serial::async_machine<200>;
+
+serial::fix_task take_fixes(rmc_machine & m, std::vector<int> & seconds, size_t count)
+{
+    while (seconds.size() != count)
+    {
+        auto const fix = co_await m.next_fix();
+        seconds.push_back(fix.time.seconds);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (test_await_fixes)
+{
+    std::byte memory[1024];
+    serial::frame_arena arena(memory);
+    rmc_machine m;
+    std::vector<int> seconds;
+    seconds.reserve(6);
+
+    auto const allocated = allocations;
+    serial::fix_task task = [&] {
+        serial::frame_arena::use in(arena);
+        return take_fixes(m, seconds, 6);
+    }();
+    BOOST_CHECK(arena.used() > 0);
+    BOOST_CHECK(m.waiting());
+    for (size_t round = 0; round < 2; ++round)
+    {
+        for (size_t offset = 0; offset < sizeof(stream) - 1; offset += 9)
+        {
+            m.fill_data(stream + offset, std::min<size_t>(9, sizeof(stream) - 1 - offset));
+        }
+    }
+    BOOST_CHECK_EQUAL(allocations, allocated);
+    BOOST_CHECK(task.done());
+    BOOST_CHECK(!m.waiting());
+    BOOST_CHECK(seconds == (std::vector<int> {36, 46, 40, 36, 46, 40}));
+}
+
+serial::fix_task take_all(serial::async_machine<512, serial::any_sentence> & m, std::vector<size_t> & kinds, size_t count)
+{
+    while (kinds.size() != count)
+    {
+        kinds.push_back((co_await m.next_fix()).index());
+    }
+}
+
+BOOST_AUTO_TEST_CASE (test_await_any_sentence)
+{
+    serial::async_machine<512, serial::any_sentence> m;
+    m.fill_data(stream, sizeof(stream) - 1); // ready before anyone awaits
+    std::vector<size_t> kinds;
+    auto task = take_all(m, kinds, 4);
+    BOOST_CHECK(task.done());
+    BOOST_CHECK(kinds == (std::vector<size_t> {0, 0, 1, 0}));
+}
@@ -1,6 +1,24 @@
 #define BOOST_TEST_MODULE boost_test_module_
 #include <boost/test/unit_test.hpp> // UTF ??
 #include <machine.h>
+#include <batch.h>
+#include <bulk.h>
+#include <mapped.h>
+#include <spsc.h>
+#include <pool.h>
+#include <uring.h>
+#include <push.h>
+#include <replay.h>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <fcntl.h>
+#include <pty.h>
+#include <sys/stat.h>
+#include <termios.h>
 
 struct rmc_callback1 // callback for test_machine class
 {
@@ -40,9 +58,14 @@ struct rmc_callback2 // callback for rotated_parse_test_machine class
         // add checks yourself and ensure all values are right.
     }
 };
+template <size_t bs>
+struct ring_sized_traits : serial::default_traits // rings smaller than the longest sentence take shorter ones
+{
+    static constexpr uint16_t max_sentence_size = std::min<size_t>(bs - 3, serial::max_sentence_size);
+};
 template <size_t bs, class callback=rmc_callback2>
-struct rotated_parse_test_machine : public serial::machine<bs, callback> {
-    using parent_class_type = serial::machine<bs, callback>;
+struct rotated_parse_test_machine : public serial::machine<bs, callback, ring_sized_traits<bs>> {
+    using parent_class_type = serial::machine<bs, callback, ring_sized_traits<bs>>;
     using parent_class_type::current_state;
     using parent_class_type::begin;
     using parent_class_type::end;
@@ -66,7 +89,7 @@ BOOST_AUTO_TEST_CASE( test_empty_machine_data )
     BOOST_REQUIRE(m.size() == 0);
     BOOST_REQUIRE_NO_THROW(parse_result = m.parse());
     BOOST_REQUIRE_EQUAL(parse_result, false);
-    BOOST_REQUIRE(m.current_state == m.get_parse_$_state().get());
+    BOOST_REQUIRE(m.current_state == state_id::parse_$);
 }
 
 BOOST_AUTO_TEST_CASE( test_$_and_same_state )
@@ -80,7 +103,7 @@ BOOST_AUTO_TEST_CASE( test_$_and_same_state )
     bool parse_result {};
     BOOST_REQUIRE_NO_THROW(parse_result = m.parse());
     BOOST_REQUIRE_EQUAL(parse_result, false);
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_$_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_$);
     BOOST_REQUIRE_EQUAL(m.size() , 0u);
 }
 
@@ -94,7 +117,7 @@ BOOST_AUTO_TEST_CASE( test_$_and_switch_state )
     bool parse_result {};
     parse_result = m.parse();
     BOOST_REQUIRE_EQUAL(parse_result, true);
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_rmc_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_id);
     BOOST_REQUIRE_EQUAL (*m.get_start() ,(int)'G');
     BOOST_REQUIRE_EQUAL (*m.begin() ,(int)'G');
     BOOST_REQUIRE_EQUAL(m.size() , 2u);
@@ -110,7 +133,7 @@ BOOST_AUTO_TEST_CASE( test_insufficient_rmc_and_same_state )
 
     while (m.parse()) {}
 
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_rmc_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_id);
     BOOST_REQUIRE_EQUAL(m.size() , 3u);
     BOOST_REQUIRE (m.get_start() == m.begin());
 }
@@ -127,7 +150,7 @@ BOOST_AUTO_TEST_CASE( test_wrong_rmc_and_switch_$_state )
     while ( (pres = m.parse())) {}
 
     BOOST_REQUIRE(!pres);
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_$_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_$);
     BOOST_REQUIRE_EQUAL(m.size() , 0u);
     BOOST_REQUIRE (m.get_start() != m.begin());
 
@@ -143,7 +166,7 @@ BOOST_AUTO_TEST_CASE( test_rmc_and_switch_state )
 
     while (m.parse()) {}
 
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_crlf_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_crlf);
     BOOST_REQUIRE_EQUAL(m.size() , 1u);
     BOOST_REQUIRE_EQUAL(*m.begin() , '_');
 }
@@ -158,7 +181,7 @@ BOOST_AUTO_TEST_CASE( test_crlf_state_no_CR_LF_and_max_search_size )
 
     while (m.parse()) {}
 
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_$_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_$);
     BOOST_REQUIRE_EQUAL(m.size() , 0u);
 }
 
@@ -172,7 +195,7 @@ BOOST_AUTO_TEST_CASE( test_crlf_state_CR_only )
 
     while (m.parse()) {}
 
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_crlf_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_crlf);
     BOOST_REQUIRE_EQUAL(m.size() , 1u);
     BOOST_REQUIRE_EQUAL(*m.begin() , '\x0D');
 }
@@ -190,7 +213,7 @@ BOOST_AUTO_TEST_CASE( test_crlf_state_CR_LF )
     pres = m.parse(); // CRLF
 
 
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_checksum_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_checksum);
     BOOST_REQUIRE (pres);
 }
 
@@ -207,7 +230,7 @@ BOOST_AUTO_TEST_CASE( test_checksum_state_1)
     pres = m.parse(); // CRLF
     pres = m.parse(); //CS -> $
 
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_$_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_$);
     BOOST_REQUIRE (pres);
     BOOST_REQUIRE_EQUAL (m.size(), 0u);
 }
@@ -228,7 +251,7 @@ BOOST_AUTO_TEST_CASE( test_checksum_state_2)
     pres = m.parse(); //CS -> $
 
     BOOST_REQUIRE_EQUAL(m.proc_call, save_proc_call);
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_$_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_$);
     BOOST_REQUIRE (pres);
     BOOST_REQUIRE_EQUAL (m.size(), 0u);
 }
@@ -247,7 +270,7 @@ BOOST_AUTO_TEST_CASE( test_successful_checksum)
     pres = m.parse(); // CS -> $
 
     BOOST_REQUIRE_EQUAL(m.proc_call, save_proc_call + 1);
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_$_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_$);
     BOOST_REQUIRE (pres);
 }
 
@@ -264,7 +287,19 @@ BOOST_AUTO_TEST_CASE( test_2_messages)
     while(m.parse()) {}
 
     BOOST_REQUIRE_EQUAL(m.proc_call, save_proc_call + 2);
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_$_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_$);
+}
+
+BOOST_AUTO_TEST_CASE( test_parse_all)
+{
+    using namespace serial;
+    test_machine m;
+    char external_buffer[] = {"$GPRMC,081836.000,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*75\x0D\x0A$GPRMC,225446,A,4916.45,N,12311.12,W,000.5,054.7,191119,020.3,E*6D\x0D\x0A$GPR"};
+    m.fill_data(external_buffer, sizeof(external_buffer) - 1);
+    m.parse_all();
+
+    BOOST_REQUIRE_EQUAL(m.proc_call, 2);
+    BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_id);
 }
 
 template <int T>
@@ -283,7 +318,7 @@ constexpr void rotated_parse (std::integral_constant<int, T>  sz)
     while(m.parse()) {}
 
     BOOST_REQUIRE_EQUAL(m.proc_call, save_proc_call + 2);
-    BOOST_REQUIRE_EQUAL(m.current_state, m.get_parse_$_state().get());
+    BOOST_REQUIRE_EQUAL(m.current_state, serial::state_id::parse_$);
 }
 
 BOOST_AUTO_TEST_CASE( test_rotated_parse)
@@ -298,16 +333,390 @@ BOOST_AUTO_TEST_CASE( test_rotated_parse)
     rotated_parse(std::integral_constant<int, 100>());
 }
 
+BOOST_AUTO_TEST_CASE( test_independent_machines )
+{
+    using namespace serial;
+    test_machine m1;
+    test_machine m2;
+    char external_buffer1[] = {"$GPRMC,081836.000,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*75\x0D\x0A"};
+    char external_buffer2[] = {"$GPRMC,225446,A,4916.45,N,12311.12,W,000.5,054.7,191119,020.3,E*6D\x0D\x0A"};
+
+    m1.fill_data(external_buffer1, sizeof(external_buffer1)/2);
+    while(m1.parse()) {}
+    m2.fill_data(external_buffer2, sizeof(external_buffer2)/2);
+    while(m2.parse()) {}
+    m1.fill_data(external_buffer1 + sizeof(external_buffer1)/2, sizeof(external_buffer1) - sizeof(external_buffer1)/2);
+    while(m1.parse()) {}
+    m2.fill_data(external_buffer2 + sizeof(external_buffer2)/2, sizeof(external_buffer2) - sizeof(external_buffer2)/2);
+    while(m2.parse()) {}
+
+    BOOST_REQUIRE_EQUAL(m1.proc_call, 1);
+    BOOST_REQUIRE_EQUAL(m2.proc_call, 1);
+}
+
+BOOST_AUTO_TEST_CASE( test_machines_in_vector )
+{
+    using namespace serial;
+    char external_buffer[] = {"$GPRMC,081836.000,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*75\x0D\x0A"};
+    std::vector<test_machine> ports(1);
+
+    for (size_t head = 10; head < sizeof(external_buffer); head += 10)
+    {
+        auto & m = ports.back();
+        m.fill_data(external_buffer, head);
+        while(m.parse()) {}
+        ports.emplace_back(); // the machine in flight is relocated here
+        auto & moved = ports[ports.size() - 2];
+        moved.fill_data(external_buffer + head, sizeof(external_buffer) - head);
+        while(moved.parse()) {}
+        BOOST_REQUIRE_EQUAL(moved.proc_call, 1);
+        BOOST_REQUIRE(moved.current_state == state_id::parse_$);
+    }
+    BOOST_REQUIRE_EQUAL(ports.back().proc_call, 0);
+}
+
+struct rmc_counter // counts the sentences decoded by span_test_machine
+{
+    static inline int calls = 0;
+    static void callback(serial::minmea_sentence_rmc const &)
+    {
+        ++calls;
+    }
+};
+using span_test_machine = serial::machine<200, rmc_counter>;
+
+char const mixed_stream[] = "$GPRMC,081836.000,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*75\x0D\x0A"
+                            "BROKEN,072635.327,BROKEN.406,N,01324.297,E,383.9,000.0,140220,000.0,W*73\x0D\x0A"
+                            "$GPRMC,225446,A,4916.45,N,12311.12,W,000.5,054.7,191119,020.3,E*6D\x0D\x0A"
+                            "$GPRMC,BROKEN.327,A,5230.428,N,01324.307,E,082.2,000.0,140220,000.0,W*7C\x0D\x0A"
+                            "$GPRMC,,V,,,,,,,080907,9.6,E,N*31\x0D\x0A"
+                            "$GPRMC,072639.327,A,5230.331,N,01324.153,E,487.1,000.0,140220,000.0,W*7C BROKEN "
+                            "$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*6B\x0D\x0A";
+
+BOOST_AUTO_TEST_CASE( test_span_parse_whole_sentences )
+{
+    using namespace serial;
+    span_test_machine m;
+    rmc_counter::calls = 0;
+
+    m.parse(mixed_stream, sizeof(mixed_stream) - 1);
+
+    BOOST_REQUIRE_EQUAL(rmc_counter::calls, 4);
+    BOOST_REQUIRE(m.idle());
+}
+
+BOOST_AUTO_TEST_CASE( test_span_parse_chunked )
+{
+    using namespace serial;
+    for (size_t chunk = 1; chunk < sizeof(mixed_stream); ++chunk)
+    {
+        span_test_machine m;
+        rmc_counter::calls = 0;
+        for (size_t offset = 0; offset < sizeof(mixed_stream) - 1; offset += chunk)
+        {
+            m.parse(mixed_stream + offset, std::min(chunk, sizeof(mixed_stream) - 1 - offset));
+        }
+        BOOST_REQUIRE_EQUAL(rmc_counter::calls, 4);
+        BOOST_REQUIRE(m.idle());
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_delimiter_scanner )
+{
+    using namespace serial;
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<> dis (0, 399);
+    char const delimiters[] = {'$', '\x0D', '\x0A', '*'};
+    char bytes[300];
+    for (auto & b : bytes)
+    {
+        auto const r = dis(gen);
+        b = r < 4 ? delimiters[r] : 'G';
+    }
+    bytes[sizeof(bytes) - 1] = '\x0D'; // CR-LF across the segments
+    bytes[0] = '\x0A';
+
+    std::vector<block_classifier> classifiers {classify_scalar};
+#ifdef SERIAL_SCANNER_X86
+    classifiers.push_back(classify_sse2);
+    if (__builtin_cpu_supports("avx2"))
+    {
+        classifiers.push_back(classify_avx2);
+    }
+#endif
+    classifiers.push_back(classifier()); // the one find_delimiters() takes by default
+
+    for (size_t split = 0; split < sizeof(bytes); ++split)
+    {
+        std::string const flat = std::string(bytes + split, sizeof(bytes) - split) + std::string(bytes, split);
+        auto const expected = [&flat](char const * what)
+        {
+            auto const pos = flat.find(what);
+            return pos == std::string::npos ? flat.size() : pos;
+        };
+        ring_segments const segments {{bytes + split, sizeof(bytes) - split}, {bytes, split}};
+        for (auto const classify : classifiers)
+        {
+            auto const offsets = find_delimiters(segments, dollar_delimiter | crlf_delimiter | star_delimiter, classify);
+            BOOST_REQUIRE_EQUAL(offsets.dollar, expected("$"));
+            BOOST_REQUIRE_EQUAL(offsets.crlf, expected("\x0D\x0A"));
+            BOOST_REQUIRE_EQUAL(offsets.star, expected("*"));
+        }
+    }
+}
+BOOST_AUTO_TEST_CASE( test_parse_batch )
+{
+    using namespace serial;
+    minmea_sentence_rmc frames[10] {};
+    auto const result = parse_batch(mixed_stream, sizeof(mixed_stream) - 1, span<minmea_sentence_rmc>(frames));
+
+    BOOST_REQUIRE_EQUAL(result.decoded, 4u);
+    BOOST_REQUIRE_EQUAL(result.checksum_failed, 1u);
+    BOOST_REQUIRE_EQUAL(result.malformed, 1u);
+    BOOST_REQUIRE_EQUAL(result.consumed, sizeof(mixed_stream) - 1);
+    BOOST_REQUIRE_EQUAL(frames[0].latitude.value, -375165);
+    BOOST_REQUIRE_EQUAL(frames[1].latitude.value, 491645);
+    BOOST_REQUIRE(!frames[2].valid);
+    BOOST_REQUIRE_EQUAL(frames[3].time.seconds, 36);
+}
+
+BOOST_AUTO_TEST_CASE( test_parse_batch_resumed )
+{
+    using namespace serial;
+    minmea_sentence_rmc frames[2] {};
+    auto const first = parse_batch(mixed_stream, 180, span<minmea_sentence_rmc>(frames)); // ends within a sentence
+    BOOST_REQUIRE_EQUAL(first.decoded, 1u);
+    BOOST_REQUIRE_EQUAL(mixed_stream[first.consumed], '$');
+
+    auto const second = parse_batch(mixed_stream + first.consumed, sizeof(mixed_stream) - 1 - first.consumed, span<minmea_sentence_rmc>(frames)); // the array fills up
+    BOOST_REQUIRE_EQUAL(second.decoded, 2u);
+    BOOST_REQUIRE_EQUAL(frames[1].date.year, 7);
+
+    auto const rest = first.consumed + second.consumed;
+    auto const third = parse_batch(mixed_stream + rest, sizeof(mixed_stream) - 1 - rest, span<minmea_sentence_rmc>(frames));
+    BOOST_REQUIRE_EQUAL(third.decoded, 1u);
+    BOOST_REQUIRE_EQUAL(first.checksum_failed + second.checksum_failed + third.checksum_failed, 1u);
+}
+
+struct mixed_callback // checks every sentence type of mixed_sentences
+{
+    static inline int calls = 0;
+    static void callback(serial::minmea_sentence_rmc const & rmc)
+    {
+        ++calls;
+        BOOST_CHECK_EQUAL (rmc.latitude.value, -375165);
+    }
+    static void callback(serial::minmea_sentence_gga const & gga)
+    {
+        ++calls;
+        BOOST_CHECK_EQUAL (gga.time.hours, 12);
+        BOOST_CHECK_EQUAL (gga.time.seconds, 19);
+        BOOST_CHECK_EQUAL (gga.latitude.value, 4807038);
+        BOOST_CHECK_EQUAL (gga.latitude.scale, 1000);
+        BOOST_CHECK_EQUAL (gga.longitude.value, 1131000);
+        BOOST_CHECK_EQUAL (gga.fix_quality, 1);
+        BOOST_CHECK_EQUAL (gga.satellites_tracked, 8);
+        BOOST_CHECK_EQUAL (gga.hdop.value, 9);
+        BOOST_CHECK_EQUAL (gga.altitude.value, 5454);
+        BOOST_CHECK_EQUAL (gga.altitude_units, 'M');
+        BOOST_CHECK_EQUAL (gga.height.value, 469);
+        BOOST_CHECK_EQUAL (gga.dgps_age.scale, 0);
+    }
+    static void callback(serial::minmea_sentence_gll const & gll)
+    {
+        ++calls;
+        BOOST_CHECK_EQUAL (gll.latitude.value, 491645);
+        BOOST_CHECK_EQUAL (gll.longitude.value, -1231112);
+        BOOST_CHECK_EQUAL (gll.time.minutes, 54);
+        BOOST_CHECK_EQUAL (gll.status, 'A');
+        BOOST_CHECK_EQUAL (gll.mode, '\0');
+    }
+    static void callback(serial::minmea_sentence_gsa const & gsa)
+    {
+        ++calls;
+        int const sats[12] {4, 5, 0, 9, 12, 0, 0, 24, 0, 0, 0, 0};
+        BOOST_CHECK_EQUAL (gsa.mode, 'A');
+        BOOST_CHECK_EQUAL (gsa.fix_type, 3);
+        BOOST_CHECK_EQUAL_COLLECTIONS (gsa.sats, gsa.sats + 12, sats, sats + 12);
+        BOOST_CHECK_EQUAL (gsa.pdop.value, 25);
+        BOOST_CHECK_EQUAL (gsa.vdop.value, 21);
+    }
+    static void callback(serial::minmea_sentence_gsv const & gsv)
+    {
+        ++calls;
+        BOOST_CHECK_EQUAL (gsv.total_msgs, 2);
+        BOOST_CHECK_EQUAL (gsv.msg_nr, 1);
+        BOOST_CHECK_EQUAL (gsv.total_sats, 8);
+        BOOST_CHECK_EQUAL (gsv.sats[0].azimuth, 83);
+        BOOST_CHECK_EQUAL (gsv.sats[3].nr, 14);
+        BOOST_CHECK_EQUAL (gsv.sats[3].snr, 45);
+    }
+    static void callback(serial::minmea_sentence_vtg const & vtg)
+    {
+        ++calls;
+        BOOST_CHECK_EQUAL (vtg.true_track_degrees.value, 547);
+        BOOST_CHECK_EQUAL (vtg.magnetic_track_degrees.value, 344);
+        BOOST_CHECK_EQUAL (vtg.speed_knots.value, 55);
+        BOOST_CHECK_EQUAL (vtg.speed_kph.value, 102);
+    }
+    static void callback(serial::minmea_sentence_zda const & zda)
+    {
+        ++calls;
+        BOOST_CHECK_EQUAL (zda.time.hours, 20);
+        BOOST_CHECK_EQUAL (zda.date.day, 4);
+        BOOST_CHECK_EQUAL (zda.date.month, 7);
+        BOOST_CHECK_EQUAL (zda.date.year, 2002);
+        BOOST_CHECK_EQUAL (zda.hour_offset, 0);
+    }
+};
+
+struct gga_callback // takes nothing but GGA
+{
+    static inline int calls = 0;
+    static void callback(serial::minmea_sentence_gga const &)
+    {
+        ++calls;
+    }
+};
+
+char const mixed_sentences[] = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\x0D\x0A"
+                               "$GPTXT,01,01,02,ANTSTATUS=OK*3B\x0D\x0A"
+                               "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39\x0D\x0A"
+                               "$GPRMC,081836.000,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*75\x0D\x0A"
+                               "$GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45*75\x0D\x0A"
+                               "$GPGLL,4916.45,N,12311.12,W,225444,A,*1D\x0D\x0A"
+                               "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48\x0D\x0A"
+                               "$GPZDA,201530.00,04,07,2002,00,00*60\x0D\x0A";
+
+BOOST_AUTO_TEST_CASE( test_mixed_sentences )
+{
+    using namespace serial;
+    for (size_t chunk = 1; chunk < sizeof(mixed_sentences); chunk += 5)
+    {
+        machine<600, mixed_callback> m;
+        mixed_callback::calls = 0;
+        for (size_t offset = 0; offset < sizeof(mixed_sentences) - 1; offset += chunk)
+        {
+            m.fill_data(mixed_sentences + offset, std::min(chunk, sizeof(mixed_sentences) - 1 - offset));
+            while (m.parse());
+        }
+        BOOST_REQUIRE_EQUAL(mixed_callback::calls, 7);
+
+        mixed_callback::calls = 0;
+        m.parse(mixed_sentences, sizeof(mixed_sentences) - 1);
+        BOOST_REQUIRE_EQUAL(mixed_callback::calls, 7);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_unregistered_sentences_skipped )
+{
+    using namespace serial;
+    machine<600, gga_callback> m;
+    gga_callback::calls = 0;
+    m.fill_data(mixed_sentences, sizeof(mixed_sentences) - 1);
+    while (m.parse());
+    m.parse(mixed_sentences, sizeof(mixed_sentences) - 1);
+
+    BOOST_REQUIRE_EQUAL(gga_callback::calls, 2);
+    BOOST_REQUIRE(!(machine<600, gga_callback>::registered(sentence_id::rmc)));
+    BOOST_REQUIRE(m.idle());
+}
+
+
+BOOST_AUTO_TEST_CASE( test_rmc_schema_fields )
+{
+    using namespace serial;
+    minmea_sentence_rmc f {};
+    auto const parse = [&f](char const * fields)
+    {
+        f = minmea_sentence_rmc {};
+        return minmea_parse_rmc(&f, fields, fields + std::strlen(fields));
+    };
+
+    // no fields at all, every one at its default
+    BOOST_REQUIRE(parse(""));
+    BOOST_REQUIRE_EQUAL(f.time.hours, -1);
+    BOOST_REQUIRE_EQUAL(f.time.microseconds, -1);
+    BOOST_REQUIRE(!f.valid);
+    BOOST_REQUIRE_EQUAL(f.latitude.value, 0);
+    BOOST_REQUIRE_EQUAL(f.latitude.scale, 0);
+    BOOST_REQUIRE_EQUAL(f.date.year, -1);
+
+    // signs and hemispheres
+    BOOST_REQUIRE(parse("123456.7,A,-5230.5,N,+01324.25,W,,,010203,3.5,W"));
+    BOOST_REQUIRE_EQUAL(f.time.hours, 12);
+    BOOST_REQUIRE_EQUAL(f.time.minutes, 34);
+    BOOST_REQUIRE_EQUAL(f.time.seconds, 56);
+    BOOST_REQUIRE_EQUAL(f.time.microseconds, 700000);
+    BOOST_REQUIRE(f.valid);
+    BOOST_REQUIRE_EQUAL(f.latitude.value, -52305);
+    BOOST_REQUIRE_EQUAL(f.latitude.scale, 10);
+    BOOST_REQUIRE_EQUAL(f.longitude.value, -132425);
+    BOOST_REQUIRE_EQUAL(f.longitude.scale, 100);
+    BOOST_REQUIRE_EQUAL(f.speed.scale, 0);
+    BOOST_REQUIRE_EQUAL(f.date.day, 1);
+    BOOST_REQUIRE_EQUAL(f.date.month, 2);
+    BOOST_REQUIRE_EQUAL(f.date.year, 3);
+    BOOST_REQUIRE_EQUAL(f.variation.value, -35);
+    BOOST_REQUIRE(!parse(",,5230.5,X"));
+
+    // an overflow fails the integer part and truncates the fraction
+    BOOST_REQUIRE(!parse(",,99999999999"));
+    BOOST_REQUIRE(parse(",,1.9999999999,N"));
+    BOOST_REQUIRE_EQUAL(f.latitude.value, 1999999999);
+    BOOST_REQUIRE_EQUAL(f.latitude.scale, 1000000000);
+
+    // a sign or a point with no digits, a space after them
+    BOOST_REQUIRE(!parse(",,-"));
+    BOOST_REQUIRE(!parse(",,."));
+    BOOST_REQUIRE(!parse(",,+.,N"));
+    BOOST_REQUIRE(!parse(",,1 "));
+    BOOST_REQUIRE(parse(",, 1"));
+
+    // times and dates of fewer than six digits
+    BOOST_REQUIRE(!parse("12345,A"));
+    BOOST_REQUIRE(!parse("12345"));
+    BOOST_REQUIRE(!parse(",,,,,,,,1402"));
+    BOOST_REQUIRE(parse(",,,,,,,,140220"));
+    BOOST_REQUIRE_EQUAL(f.date.year, 20);
+}
+
+BOOST_AUTO_TEST_CASE( test_zda_offsets )
+{
+    using namespace serial;
+    minmea_sentence_zda f {};
+    auto const parse = [&f](char const * fields)
+    {
+        f = minmea_sentence_zda {};
+        return minmea_parse_zda(&f, fields, fields + std::strlen(fields));
+    };
+
+    BOOST_REQUIRE(parse("201530.00,04,07,2002,-13,45"));
+    BOOST_REQUIRE_EQUAL(f.hour_offset, -13);
+    BOOST_REQUIRE_EQUAL(f.minute_offset, 45);
+    BOOST_REQUIRE(parse("201530.00,04,07,2002,13,0"));
+    BOOST_REQUIRE(parse("201530.00,04,07,2002")); // no zone, the offsets at 0
+    BOOST_REQUIRE(!parse("201530.00,04,07,2002,14,00"));
+    BOOST_REQUIRE(!parse("201530.00,04,07,2002,-14,00"));
+    BOOST_REQUIRE(!parse("201530.00,04,07,2002,00,60"));
+    BOOST_REQUIRE(!parse("201530.00,04,07,2002,00,-1"));
+}
 
 std::size_t memory = 0;
 std::size_t alloc = 0;
-void* operator new(std::size_t s) noexcept(false)
+// out of line, so that GCC does not see free() called on what operator new returned
+[[gnu::noinline]] void* operator new(std::size_t s) noexcept(false)
 {
     memory += s;
     ++alloc;
     return malloc(s);
 }
-void operator delete(void* p) throw()
+[[gnu::noinline]] void operator delete(void* p) throw()
+{
+    --alloc;
+    free(p);
+}
+[[gnu::noinline]] void operator delete(void* p, std::size_t) throw()
 {
     --alloc;
     free(p);
@@ -330,3 +739,1132 @@ BOOST_AUTO_TEST_CASE (test_memory_allocations)
     BOOST_CHECK_EQUAL (mem1, mem2);
     BOOST_CHECK_EQUAL (alloc1, alloc2);
 }
+
+struct port_sink // a stateful callback, one per port
+{
+    int port;
+    int * fixes;
+    void operator()(serial::minmea_sentence_rmc const &) const
+    {
+        ++fixes[port];
+    }
+};
+
+BOOST_AUTO_TEST_CASE (test_stateful_callbacks)
+{
+    using namespace serial;
+    char const external_buffer[] = {"$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*6B\x0D\x0A"};
+    int fixes[3] {};
+    std::vector<machine<200, port_sink>> ports;
+    for (int port = 0; port < 3; ++port)
+    {
+        ports.emplace_back(port_sink {port, fixes});
+    }
+
+    auto [mem1, alloc1] = memory_use();
+    int valid_fixes = 0;
+    auto lambda_machine = make_machine<200>([&valid_fixes](minmea_sentence_rmc const & rmc) { valid_fixes += rmc.valid; });
+    int any_sentences = 0;
+    auto any_sentence = [&any_sentences](auto const &) { ++any_sentences; };
+    machine<200, callback_ref<minmea_sentence_rmc>> ref_machine(any_sentence);
+
+    for (int port = 0; port < 3; ++port)
+    {
+        for (int n = 0; n <= port; ++n)
+        {
+            ports[port].parse(external_buffer, sizeof(external_buffer) - 1);
+        }
+    }
+    lambda_machine.fill_data(external_buffer, sizeof(external_buffer) - 1);
+    while (lambda_machine.parse());
+    ref_machine.parse(external_buffer, sizeof(external_buffer) - 1);
+    auto [mem2, alloc2] = memory_use();
+
+    BOOST_CHECK_EQUAL (mem1, mem2);
+    BOOST_CHECK_EQUAL (alloc1, alloc2);
+    BOOST_CHECK_EQUAL (fixes[0], 1);
+    BOOST_CHECK_EQUAL (fixes[1], 2);
+    BOOST_CHECK_EQUAL (fixes[2], 3);
+    BOOST_CHECK_EQUAL (valid_fixes, 1);
+    BOOST_CHECK_EQUAL (any_sentences, 1);
+}
+
+struct sentence_log // notes a few fields of every frame, to compare decoders by
+{
+    std::vector<std::string> * lines;
+    void operator()(serial::minmea_sentence_rmc const & f) const
+    {
+        lines->push_back("rmc " + std::to_string(f.time.seconds) + ' ' + std::to_string(f.latitude.value) + ' ' + std::to_string(f.date.year));
+    }
+    void operator()(serial::minmea_sentence_gga const & f) const
+    {
+        lines->push_back("gga " + std::to_string(f.time.seconds) + ' ' + std::to_string(f.altitude.value));
+    }
+    void operator()(serial::minmea_sentence_gsv const & f) const
+    {
+        lines->push_back("gsv " + std::to_string(f.total_sats) + ' ' + std::to_string(f.sats[3].azimuth));
+    }
+    void operator()(serial::minmea_sentence_zda const & f) const
+    {
+        lines->push_back("zda " + std::to_string(f.date.year));
+    }
+};
+
+struct sentence_text_log : sentence_log // the proprietary sentences too
+{
+    using sentence_log::operator();
+    void operator()(serial::proprietary_sentence const & sentence) const
+    {
+        lines->emplace_back(sentence.text.first.begin(), sentence.text.first.end());
+        lines->back().append(sentence.text.second.begin(), sentence.text.second.end());
+    }
+};
+
+struct throwing_log
+{
+    size_t * calls;
+    void operator()(serial::minmea_sentence_rmc const &) const
+    {
+        if (++*calls == 3)
+        {
+            throw std::runtime_error("callback failed");
+        }
+    }
+};
+
+BOOST_AUTO_TEST_CASE (test_bulk_decoder)
+{
+    using namespace serial;
+    std::string data;
+    std::mt19937 gen(9);
+    std::uniform_int_distribution<int> pick(0, 9);
+    for (int i = 0; i < 200; ++i)
+    {
+        switch (pick(gen))
+        {
+            case 0: data += "$GPRMC,0818"; break; // cut short
+            case 1: data += std::string(pick(gen) * 20, 'x'); break;
+            case 2: data += "\x0D\x0A\x0D"; break;
+            default: data += (i % 2) ? mixed_sentences : mixed_stream; break;
+        }
+        if (i % 25 == 0)
+        {
+            data += "$PGRME,15.0,M,45.0,M,25.0,M*1C\x0D\x0A";
+        }
+    }
+
+    std::vector<std::string> expected;
+    machine<600, sentence_text_log> m(sentence_text_log {{&expected}});
+    m.parse(data.data(), data.size());
+    BOOST_REQUIRE(expected.size() > 500);
+    BOOST_REQUIRE(std::count(expected.begin(), expected.end(), "PGRME,15.0,M,45.0,M,25.0,M*1C") > 0);
+
+    for (unsigned threads : {1u, 3u})
+    {
+        for (size_t range_size : {size_t {1}, size_t {37}, size_t {500}, size_t {1} << 20u})
+        {
+            std::vector<std::string> lines;
+            sentence_text_log log {{&lines}};
+            bulk_decoder<sentence_text_log>(threads, range_size).decode(data.data(), data.size(), log);
+            BOOST_REQUIRE(lines == expected);
+        }
+    }
+
+    // the workers are stopped and joined when the callback throws
+    for (unsigned threads : {1u, 3u})
+    {
+        size_t calls = 0;
+        throwing_log log {&calls};
+        BOOST_CHECK_THROW(bulk_decoder<throwing_log>(threads, 37).decode(data.data(), data.size(), log), std::runtime_error);
+        BOOST_CHECK_EQUAL(calls, 3u);
+    }
+
+    char path[] = "/tmp/bulk_decoder_XXXXXX";
+    auto const fd = mkstemp(path);
+    BOOST_REQUIRE(fd >= 0);
+    BOOST_REQUIRE_EQUAL(write(fd, data.data(), data.size()), (ssize_t)data.size());
+    close(fd);
+    for (size_t range_size : {size_t {3}, size_t {77}, size_t {4096}})
+    {
+        std::vector<std::string> lines;
+        sentence_text_log log {{&lines}};
+        BOOST_REQUIRE(bulk_decoder<sentence_text_log>(2, range_size).decode_file(path, log));
+        BOOST_REQUIRE(lines == expected);
+    }
+    unlink(path);
+}
+
+BOOST_AUTO_TEST_CASE (test_mapped_log)
+{
+    using namespace serial;
+    std::string const data = std::string("garbage") + mixed_sentences + mixed_stream + mixed_sentences + "$GPRMC,0818";
+    std::vector<std::string> expected;
+    machine<600, sentence_log> m(sentence_log {&expected});
+    m.parse(data.data(), data.size());
+
+    char path[] = "/tmp/mapped_log_XXXXXX";
+    auto const fd = mkstemp(path);
+    BOOST_REQUIRE(fd >= 0);
+    BOOST_REQUIRE_EQUAL(write(fd, data.data(), data.size()), (ssize_t)data.size());
+    close(fd);
+
+    mapped_log const log(path);
+    BOOST_REQUIRE(log.is_open());
+    BOOST_REQUIRE_EQUAL(log.size(), data.size());
+
+    std::vector<std::string> lines;
+    sentence_log const note {&lines};
+    for (auto const & frame : log.frames<any_sentence>())
+    {
+        std::visit([&note](auto const & f)
+        {
+            if constexpr (std::is_invocable_v<sentence_log const &, decltype(f)>)
+                note(f);
+        }, frame);
+    }
+    BOOST_REQUIRE(lines == expected);
+
+    auto const rmc = log.frames();
+    BOOST_REQUIRE_EQUAL(std::distance(rmc.begin(), rmc.end()), 6);
+    BOOST_REQUIRE_EQUAL(rmc.begin()->date.year, 19);
+    unlink(path);
+
+    BOOST_REQUIRE(!mapped_log(path).is_open());
+}
+
+struct stats_and_profile_traits : serial::counting_traits
+{
+    using profiler_type = serial::state_histogram;
+};
+
+BOOST_AUTO_TEST_CASE (test_parser_stats)
+{
+    using namespace serial;
+    static_assert(sizeof(machine<200, rmc_counter>) < sizeof(machine<200, rmc_counter, counting_traits>));
+
+    machine<200, rmc_counter, stats_and_profile_traits> ring;
+    for (size_t offset = 0; offset < sizeof(mixed_stream) - 1; offset += 7)
+    {
+        ring.fill_data(mixed_stream + offset, std::min<size_t>(7, sizeof(mixed_stream) - 1 - offset));
+        while (ring.parse());
+    }
+    machine<200, rmc_counter, counting_traits> span;
+    span.parse(mixed_stream, sizeof(mixed_stream) - 1);
+
+    for (auto const & stats : {ring.stats(), span.stats()})
+    {
+        BOOST_CHECK_EQUAL(stats.bytes_consumed, sizeof(mixed_stream) - 1);
+        BOOST_CHECK_EQUAL(stats.garbage_bytes, 112); // the BROKEN line and the tail of the sentence with no CR-LF after the resync
+        BOOST_CHECK_EQUAL(stats.sentences[static_cast<size_t>(sentence_id::rmc)], 6);
+        BOOST_CHECK_EQUAL(stats.checksum_failures, 1);
+        BOOST_CHECK_EQUAL(stats.resyncs, 1);
+        BOOST_CHECK_EQUAL(stats.malformed, 0);
+        BOOST_CHECK_EQUAL(stats.field_errors, 0);
+        BOOST_CHECK_EQUAL(stats.ring_full_events, 0);
+    }
+
+    for (size_t state = 0; state < state_count; ++state)
+    {
+        uint64_t runs = 0;
+        for (auto const n : ring.profile().runs[state])
+        {
+            runs += n;
+        }
+        BOOST_CHECK(runs > 0);
+    }
+
+    machine<100, rmc_counter, counting_traits> small;
+    small.fill_data(mixed_stream, 60);
+    small.fill_data(mixed_stream + 60, 60);
+    BOOST_CHECK_EQUAL(small.stats().ring_full_events, 1);
+}
+
+BOOST_AUTO_TEST_CASE (test_checksum)
+{
+    using namespace serial;
+    BOOST_CHECK_EQUAL(hex_byte('7', 'C'), 0x7Cu);
+    BOOST_CHECK_EQUAL(hex_byte('a', 'f'), 0xAFu);
+    BOOST_CHECK(hex_byte('7', 'G') > 0xFF);
+    BOOST_CHECK(hex_byte('\x0D', '0') > 0xFF);
+
+    std::mt19937 gen(13);
+    std::uniform_int_distribution<int> byte(0, 255);
+    char data[100];
+    for (auto & c : data)
+    {
+        c = char(byte(gen));
+    }
+    for (size_t n = 0; n <= sizeof(data); ++n)
+    {
+        uint8_t sum = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            sum ^= uint8_t(data[i]);
+        }
+        BOOST_REQUIRE_EQUAL(xor_bytes(data + 0, n), sum);
+        for (size_t cut = 0; cut <= n; cut += 3)
+        {
+            BOOST_REQUIRE_EQUAL(xor_bytes(ring_segments {{data + 0, cut}, {data + cut, n - cut}}), sum);
+        }
+    }
+}
+
+template <serial::overflow_policy policy>
+struct overflow_traits : serial::counting_traits
+{
+    static constexpr serial::overflow_policy overflow = policy;
+};
+
+BOOST_AUTO_TEST_CASE (test_backpressure)
+{
+    using namespace serial;
+    size_t const stream_size = sizeof(mixed_stream) - 1;
+    {
+        machine<100, rmc_counter, counting_traits> m;
+        rmc_counter::calls = 0;
+        BOOST_CHECK_EQUAL(m.available(), 100u);
+        size_t offset = 0;
+        while (offset != stream_size)
+        {
+            auto const accepted = m.try_fill(mixed_stream + offset, std::min<size_t>(64, stream_size - offset));
+            BOOST_REQUIRE(accepted > 0);
+            offset += accepted;
+            BOOST_REQUIRE(m.available() <= 100u - m.size());
+            while (m.parse());
+        }
+        BOOST_CHECK_EQUAL(rmc_counter::calls, 4);
+        BOOST_CHECK_EQUAL(m.stats().ring_full_events, 0);
+        BOOST_CHECK_EQUAL(m.stats().bytes_consumed, stream_size);
+    }
+    {
+        machine<100, rmc_counter, overflow_traits<overflow_policy::block>> m;
+        rmc_counter::calls = 0;
+        m.fill_data(mixed_stream, stream_size);
+        while (m.parse());
+        BOOST_CHECK_EQUAL(rmc_counter::calls, 4);
+        BOOST_CHECK(m.stats().ring_full_events > 0);
+        BOOST_CHECK_EQUAL(m.stats().dropped_bytes, 0);
+    }
+    {
+        machine<100, rmc_counter, overflow_traits<overflow_policy::drop_newest>> m;
+        rmc_counter::calls = 0;
+        m.fill_data(mixed_stream, 150);
+        BOOST_CHECK_EQUAL(m.stats().dropped_bytes, 50);
+        BOOST_CHECK_EQUAL(m.available(), 0);
+        while (m.parse());
+        BOOST_CHECK_EQUAL(rmc_counter::calls, 1);
+    }
+    {
+        machine<100, rmc_counter, overflow_traits<overflow_policy::drop_oldest>> m;
+        rmc_counter::calls = 0;
+        m.fill_data(mixed_stream, 40); // half a sentence in flight, which the next fill overwrites
+        while (m.parse());
+        m.fill_data(mixed_stream + 74, stream_size - 74);
+        BOOST_CHECK_EQUAL(m.stats().dropped_bytes, 39 + stream_size - 74 - 100); // the sentence from past its '$' on
+        while (m.parse());
+        BOOST_CHECK_EQUAL(rmc_counter::calls, 1); // the last sentence
+        m.fill_data(mixed_stream, stream_size);
+        while (m.parse());
+        BOOST_CHECK_EQUAL(rmc_counter::calls, 2);
+    }
+}
+
+template <size_t bs>
+struct drop_oldest_machine : serial::machine<bs, rmc_counter, overflow_traits<serial::overflow_policy::drop_oldest>>
+{
+    using serial::machine<bs, rmc_counter, overflow_traits<serial::overflow_policy::drop_oldest>>::current_state;
+};
+
+BOOST_AUTO_TEST_CASE (test_drop_oldest_mid_sentence)
+{
+    using namespace serial;
+    std::string const first = "$GPRMC,225446,A,4916.45,N,12311.12,W,000.5,054.7,191119,020.3,E*6D\x0D\x0A";
+    std::string const next = "$GPRMC,081836.000,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*75\x0D\x0A";
+    std::string const trailing = "01234567890123456789";
+    {
+        // the cr-lf found, the checksum not checked yet: the sentence and the oldest trailing bytes go
+        drop_oldest_machine<100> m;
+        rmc_counter::calls = 0;
+        m.fill_data((first + trailing).data(), first.size() + trailing.size());
+        m.parse(); // $
+        m.parse(); // RMC
+        m.parse(); // CRLF
+        BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_checksum);
+        auto const more = trailing + next;
+        m.fill_data(more.data(), more.size());
+        BOOST_CHECK_EQUAL(m.stats().dropped_bytes, first.size() - 1 + trailing.size() + more.size() - 100);
+        BOOST_CHECK_EQUAL(m.size(), 100u);
+        while (m.parse());
+        BOOST_CHECK_EQUAL(rmc_counter::calls, 1);
+        BOOST_CHECK(m.idle());
+    }
+    {
+        // the same with more than the ring holds
+        drop_oldest_machine<100> m;
+        rmc_counter::calls = 0;
+        m.fill_data((first + trailing).data(), first.size() + trailing.size());
+        m.parse();
+        m.parse();
+        m.parse();
+        BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_checksum);
+        auto const more = trailing + trailing + trailing + next;
+        m.fill_data(more.data(), more.size());
+        BOOST_CHECK_EQUAL(m.size(), 100u);
+        while (m.parse());
+        BOOST_CHECK_EQUAL(rmc_counter::calls, 1);
+        BOOST_CHECK(m.idle());
+    }
+    {
+        // the cr-lf still searched for: the head is given up, the next sentence is found after it
+        drop_oldest_machine<100> m;
+        rmc_counter::calls = 0;
+        m.fill_data(first.data(), 30);
+        while (m.parse());
+        BOOST_REQUIRE_EQUAL(m.current_state, state_id::parse_crlf);
+        auto const more = trailing + next;
+        m.fill_data(more.data(), more.size());
+        while (m.parse());
+        BOOST_CHECK_EQUAL(rmc_counter::calls, 1);
+        BOOST_CHECK(m.idle());
+    }
+}
+
+struct rmc_tally // counts the sentences of a machine parsed on another thread
+{
+    size_t * calls;
+    void operator()(serial::minmea_sentence_rmc const &) const
+    {
+        ++*calls;
+    }
+};
+
+BOOST_AUTO_TEST_CASE (test_spsc_machine)
+{
+    using namespace serial;
+    size_t const rounds = 2000;
+    size_t calls = 0;
+    spsc_machine<256, rmc_tally, overflow_traits<overflow_policy::block>> m(rmc_tally {&calls});
+    std::atomic<bool> done {false};
+
+    std::thread producer([&m, &done]
+    {
+        std::mt19937 gen(15);
+        std::uniform_int_distribution<size_t> dis(1, 100);
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            for (size_t offset = 0; offset < sizeof(mixed_stream) - 1;)
+            {
+                auto const chunk = std::min(dis(gen), sizeof(mixed_stream) - 1 - offset);
+                m.fill_data(mixed_stream + offset, chunk);
+                offset += chunk;
+            }
+        }
+        done = true;
+    });
+    while (!done.load() || m.parse())
+    {
+        if (!m.parse())
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    BOOST_CHECK_EQUAL(calls, 4 * rounds);
+    BOOST_CHECK_EQUAL(m.get_machine().stats().bytes_consumed, (sizeof(mixed_stream) - 1) * rounds);
+    BOOST_CHECK_EQUAL(m.get_machine().stats().dropped_bytes, 0);
+
+    // the producer can not drop the oldest bytes, which the consumer owns, and drops the newest instead
+    static_assert(spsc_machine<128, rmc_tally, overflow_traits<overflow_policy::drop_oldest>>::overflow == overflow_policy::drop_newest);
+    static_assert(spsc_machine<128, rmc_tally, overflow_traits<overflow_policy::drop_newest>>::overflow == overflow_policy::drop_newest);
+    std::string const first = "$GPRMC,081836.000,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*75\x0D\x0A";
+    std::string const second = "$GPRMC,225446,A,4916.45,N,12311.12,W,000.5,054.7,191119,020.3,E*6D\x0D\x0A";
+    calls = 0;
+    spsc_machine<128, rmc_tally, overflow_traits<overflow_policy::drop_oldest>> dropping(rmc_tally {&calls});
+    dropping.fill_data(first.data(), first.size());
+    dropping.fill_data(second.data(), second.size());
+    BOOST_CHECK_EQUAL(dropping.overflow_events(), 1u);
+    while (dropping.parse());
+    BOOST_CHECK_EQUAL(calls, 1u); // the first sentence, the second cut short
+    dropping.fill_data(second.data(), second.size());
+    while (dropping.parse());
+    BOOST_CHECK_EQUAL(calls, 2u); // found again past the cut one, which runs too long
+}
+
+struct fix_times // the times of the fixes of one port, in the order they arrive
+{
+    std::vector<int> * seconds;
+    void operator()(serial::minmea_sentence_rmc const & rmc) const
+    {
+        seconds->push_back(rmc.time.seconds);
+    }
+};
+
+BOOST_AUTO_TEST_CASE (test_parser_pool)
+{
+    using namespace serial;
+    std::vector<int> expected;
+    machine<200, fix_times> single(fix_times {&expected});
+    single.parse(mixed_stream, sizeof(mixed_stream) - 1);
+
+    size_t const ports = 16;
+    size_t const rounds = 50;
+    std::vector<std::vector<int>> seconds(ports);
+    {
+        parser_pool<256, fix_times, overflow_traits<overflow_policy::block>> pool(ports, 4, [&seconds](size_t port) { return fix_times {&seconds[port]}; });
+        std::mt19937 gen(16);
+        std::uniform_int_distribution<size_t> dis(1, 100);
+        std::vector<size_t> offsets(ports);
+        for (size_t done = 0; done != ports * rounds;)
+        {
+            auto const port = dis(gen) % ports;
+            if (offsets[port] == (sizeof(mixed_stream) - 1) * rounds)
+                continue;
+            auto const offset = offsets[port] % (sizeof(mixed_stream) - 1);
+            auto const chunk = std::min(dis(gen), sizeof(mixed_stream) - 1 - offset);
+            pool.submit(port, mixed_stream + offset, chunk);
+            offsets[port] += chunk;
+            done += (offset + chunk == sizeof(mixed_stream) - 1);
+        }
+        pool.drain();
+        for (size_t port = 0; port < ports; ++port)
+        {
+            BOOST_CHECK_EQUAL(pool.get_port(port).get_machine().stats().bytes_consumed, (sizeof(mixed_stream) - 1) * rounds);
+        }
+    }
+    for (auto const & port : seconds)
+    {
+        BOOST_REQUIRE_EQUAL(port.size(), expected.size() * rounds);
+        for (size_t i = 0; i < port.size(); ++i)
+        {
+            BOOST_REQUIRE_EQUAL(port[i], expected[i % expected.size()]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (test_uring_reader)
+{
+    using namespace serial;
+    std::vector<int> expected;
+    machine<200, fix_times> single(fix_times {&expected});
+    single.parse(mixed_stream, sizeof(mixed_stream) - 1);
+
+    std::vector<std::vector<int>> seconds(3);
+    uring_reader<256, fix_times> reader(seconds.size());
+    if (!reader.is_open())
+    {
+        BOOST_TEST_MESSAGE("no io_uring in this kernel, test_uring_reader skipped");
+        return;
+    }
+    size_t const rounds = 20;
+
+    int tty_in, tty; // a pseudo-terminal in raw mode standing in for a serial port
+    BOOST_REQUIRE_EQUAL(openpty(&tty_in, &tty, nullptr, nullptr, nullptr), 0);
+    termios mode {};
+    tcgetattr(tty, &mode);
+    cfmakeraw(&mode);
+    tcsetattr(tty, TCSANOW, &mode);
+
+    auto const fifo_path = "/tmp/uring_reader_" + std::to_string(getpid());
+    BOOST_REQUIRE_EQUAL(mkfifo(fifo_path.c_str(), 0600), 0);
+    auto const fifo = open(fifo_path.c_str(), O_RDONLY | O_NONBLOCK); // does not wait for the writer
+    auto const fifo_in = open(fifo_path.c_str(), O_WRONLY);
+    unlink(fifo_path.c_str());
+    BOOST_REQUIRE(fifo >= 0 && fifo_in >= 0);
+    fcntl(fifo, F_SETFL, 0);
+
+    char path[] = "/tmp/uring_reader_XXXXXX";
+    auto const file = mkstemp(path);
+    BOOST_REQUIRE(file >= 0);
+    unlink(path);
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        BOOST_REQUIRE_EQUAL(write(file, mixed_stream, sizeof(mixed_stream) - 1), (ssize_t)sizeof(mixed_stream) - 1);
+    }
+    lseek(file, 0, SEEK_SET);
+
+    BOOST_REQUIRE_EQUAL(reader.add(tty, fix_times {&seconds[0]}), 0u);
+    BOOST_REQUIRE_EQUAL(reader.add(fifo, fix_times {&seconds[1]}), 1u);
+    BOOST_REQUIRE_EQUAL(reader.add(file, fix_times {&seconds[2]}), 2u);
+    BOOST_CHECK(reader.add(file) == reader.npos);
+
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        BOOST_REQUIRE_EQUAL(write(tty_in, mixed_stream, sizeof(mixed_stream) - 1), (ssize_t)sizeof(mixed_stream) - 1);
+        BOOST_REQUIRE_EQUAL(write(fifo_in, mixed_stream, sizeof(mixed_stream) - 1), (ssize_t)sizeof(mixed_stream) - 1);
+        while (seconds[0].size() != expected.size() * (round + 1) || seconds[1].size() != expected.size() * (round + 1))
+        {
+            BOOST_REQUIRE(reader.run() >= 0); // the tty buffers a few KiB only
+        }
+    }
+    close(fifo_in);
+    close(tty_in); // a hang up ends the reading of the tty
+    for (size_t runs = 0; runs < 10000 && reader.reading() != 0; ++runs)
+    {
+        BOOST_REQUIRE(reader.run() >= 0);
+    }
+    BOOST_REQUIRE_EQUAL(reader.reading(), 0u);
+    BOOST_CHECK(reader.error(0) == 0 || reader.error(0) == EIO);
+    BOOST_CHECK_EQUAL(reader.error(1), 0);
+    BOOST_CHECK_EQUAL(reader.error(2), 0);
+    for (auto const & source : seconds)
+    {
+        BOOST_REQUIRE_EQUAL(source.size(), expected.size() * rounds);
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            BOOST_REQUIRE_EQUAL(source[i], expected[i % expected.size()]);
+        }
+    }
+    close(tty);
+    close(fifo);
+    close(file);
+}
+
+struct fix_log // takes the typed frames only, so they are decoded directly
+{
+    std::vector<serial::rmc_fix> * fixes;
+    void operator()(serial::rmc_fix const & fix) const
+    {
+        fixes->push_back(fix);
+    }
+};
+
+struct both_forms // takes both forms of RMC, and so gets the decoded one only
+{
+    std::vector<serial::minmea_sentence_rmc> * frames;
+    std::vector<serial::rmc_fix> * fixes;
+    void operator()(serial::minmea_sentence_rmc const & rmc) const
+    {
+        frames->push_back(rmc);
+    }
+    void operator()(serial::rmc_fix const & fix) const
+    {
+        fixes->push_back(fix);
+    }
+};
+
+BOOST_AUTO_TEST_CASE (test_generic_callback_gets_one_frame)
+{
+    using namespace serial;
+    size_t frames = 0, fixes = 0;
+    auto m = make_machine<300>([&frames, &fixes](auto const & frame)
+    {
+        if constexpr (std::is_same_v<std::decay_t<decltype(frame)>, rmc_fix>)
+            ++fixes;
+        else if constexpr (std::is_same_v<std::decay_t<decltype(frame)>, minmea_sentence_rmc>)
+            ++frames;
+    });
+    m.parse(mixed_stream, sizeof(mixed_stream) - 1);
+    BOOST_CHECK_EQUAL(frames, 4u);
+    BOOST_CHECK_EQUAL(fixes, 0u);
+}
+
+BOOST_AUTO_TEST_CASE (test_units)
+{
+    using namespace serial;
+    BOOST_CHECK_EQUAL(to_double(minmea_float {0, 0}), 0);
+    BOOST_CHECK_EQUAL(to_double(minmea_float {-7, 1}), -7);
+    for (int_least32_t scale = 10, digits = 1; digits <= 9; scale *= 10, ++digits)
+    {
+        BOOST_CHECK_CLOSE(to_double(minmea_float {123456789, scale}), 123456789.0 / scale, 1e-12);
+    }
+    BOOST_CHECK_CLOSE(to_degrees(minmea_float {-375165, 100}), -(37 + 51.65 / 60), 1e-12);
+    BOOST_CHECK_CLOSE(to_degrees(minmea_float {1450736, 100}), 145 + 7.36 / 60, 1e-12);
+    BOOST_CHECK_CLOSE(to_degrees(minmea_float {52304280, 10000}), 52 + 30.428 / 60, 1e-12);
+    BOOST_CHECK_CLOSE(knots_to_mps(minmea_float {5, 10}), 0.5 * 1852 / 3600, 1e-5);
+    BOOST_CHECK_EQUAL(days_from_civil(1970, 1, 1), 0);
+    BOOST_CHECK_EQUAL(days_from_civil(2000, 3, 1), 11017);
+    BOOST_CHECK_EQUAL(to_time_point(minmea_date {13, 9, 19}, minmea_time {8, 18, 36, 500000}).time_since_epoch().count(), 1568362716500000);
+    BOOST_CHECK_EQUAL(to_time_point(minmea_date {-1, -1, -1}, minmea_time {8, 18, 36, 0}).time_since_epoch().count(), 0);
+
+    std::vector<minmea_sentence_rmc> frames;
+    std::vector<rmc_fix> converted;
+    machine<300, both_forms> both(both_forms {&frames, &converted});
+    both.parse(mixed_stream, sizeof(mixed_stream) - 1);
+    BOOST_REQUIRE_EQUAL(frames.size(), 4u);
+    BOOST_REQUIRE(converted.empty());
+    std::transform(frames.begin(), frames.end(), std::back_inserter(converted), [](auto const & rmc) { return to_fix(rmc); });
+
+    std::vector<rmc_fix> decoded;
+    machine<300, fix_log> direct(fix_log {&decoded});
+    direct.parse(mixed_stream, sizeof(mixed_stream) - 1);
+    BOOST_REQUIRE_EQUAL(decoded.size(), frames.size());
+
+    std::vector<rmc_fix> batch(frames.size());
+    BOOST_REQUIRE_EQUAL(to_fixes({frames.data(), frames.size()}, {batch.data(), batch.size()}), frames.size());
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        for (auto const & fix : {converted[i], batch[i]})
+        {
+            BOOST_CHECK(fix.time == decoded[i].time);
+            BOOST_CHECK_EQUAL(fix.valid, decoded[i].valid);
+            BOOST_CHECK_EQUAL(fix.latitude, decoded[i].latitude);
+            BOOST_CHECK_EQUAL(fix.longitude, decoded[i].longitude);
+            BOOST_CHECK_EQUAL(fix.speed, decoded[i].speed);
+            BOOST_CHECK_EQUAL(fix.course, decoded[i].course);
+            BOOST_CHECK_EQUAL(fix.variation, decoded[i].variation);
+        }
+    }
+    BOOST_CHECK_CLOSE(decoded[0].latitude, -(37 + 51.65 / 60), 1e-12);
+    BOOST_CHECK_CLOSE(decoded[0].longitude, 145 + 7.36 / 60, 1e-12);
+    BOOST_CHECK_CLOSE(decoded[0].variation, 11.3f, 1e-5);
+    BOOST_CHECK_EQUAL(decoded[0].time.time_since_epoch().count(), 1568362716000000);
+    BOOST_CHECK_CLOSE(decoded[1].longitude, -(123 + 11.12 / 60), 1e-12);
+    BOOST_CHECK_CLOSE(decoded[1].speed, 0.5f * 1852 / 3600, 1e-5);
+    BOOST_CHECK_CLOSE(decoded[1].variation, 20.3f, 1e-5);
+
+    rmc_fix out[8];
+    auto const result = parse_batch<rmc_fix>(mixed_stream, sizeof(mixed_stream) - 1, out);
+    BOOST_REQUIRE_EQUAL(result.decoded, frames.size());
+    BOOST_CHECK_EQUAL(out[3].latitude, decoded[3].latitude);
+}
+
+char const long_stream[] = "$PGRME,15.0,M,45.0,M,25.0,M*1C\x0D\x0A"
+                           "$GNRMC,081836.000,A,3751.65432101,S,14507.36543210,E,000.000,360.000,130919,011.300,E,A,V*78\x0D\x0A"
+                           "$PUBX,00,081350.00,4717.113210,N,00833.915187,E,546.589,G3,2.1,2.0,0.007,77.52,0.007,,0.92,1.19,0.77,9,0,0*5F\x0D\x0A"
+                           "$GPRMC,225446,A,4916.45,N,12311.12,W,000.5,054.7,191119,020.3,E*6D\x0D\x0A";
+
+struct long_sentence_traits : serial::default_traits
+{
+    static constexpr uint16_t max_sentence_size = 120;
+};
+
+struct passthrough_log // the proprietary sentences and the RMC times
+{
+    std::vector<std::string> * texts;
+    std::vector<int> * seconds;
+    size_t * wrapped;
+    void operator()(serial::proprietary_sentence const & sentence) const
+    {
+        texts->emplace_back(sentence.text.first.begin(), sentence.text.first.end());
+        texts->back().append(sentence.text.second.begin(), sentence.text.second.end());
+        *wrapped += !sentence.text.second.empty();
+    }
+    void operator()(serial::minmea_sentence_rmc const & rmc) const
+    {
+        seconds->push_back(rmc.time.seconds);
+    }
+};
+
+template <class MACHINE>
+void check_passthrough(bool long_sentences)
+{
+    std::vector<std::string> const grme {"PGRME,15.0,M,45.0,M,25.0,M*1C"};
+    std::vector<std::string> const both {grme[0], "PUBX,00,081350.00,4717.113210,N,00833.915187,E,546.589,G3,2.1,2.0,0.007,"
+                                                  "77.52,0.007,,0.92,1.19,0.77,9,0,0*5F"};
+    auto const & texts_expected = long_sentences ? both : grme;
+    auto const seconds_expected = long_sentences ? std::vector<int> {36, 46} : std::vector<int> {46};
+
+    std::vector<std::string> texts;
+    std::vector<int> seconds;
+    size_t wrapped = 0;
+    MACHINE span(passthrough_log {&texts, &seconds, &wrapped});
+    span.parse(long_stream, sizeof(long_stream) - 1);
+    BOOST_CHECK(texts == texts_expected);
+    BOOST_CHECK(seconds == seconds_expected);
+
+    texts.clear();
+    seconds.clear();
+    MACHINE ring(passthrough_log {&texts, &seconds, &wrapped});
+    size_t const rounds = 20; // for the sentences to come across the end of the ring
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        for (size_t i = 0; i < sizeof(long_stream) - 1; ++i)
+        {
+            ring.fill_data(long_stream + i, 1);
+            while (ring.parse());
+        }
+    }
+    BOOST_REQUIRE_EQUAL(texts.size(), texts_expected.size() * rounds);
+    BOOST_REQUIRE_EQUAL(seconds.size(), seconds_expected.size() * rounds);
+    for (size_t i = 0; i < texts.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(texts[i], texts_expected[i % texts_expected.size()]);
+    }
+    BOOST_CHECK(wrapped > 0);
+}
+
+BOOST_AUTO_TEST_CASE (test_long_and_proprietary_sentences)
+{
+    using namespace serial;
+    check_passthrough<machine<200, passthrough_log>>(false);
+    check_passthrough<machine<128, passthrough_log, long_sentence_traits>>(true);
+
+    size_t calls = 0;
+    machine<128, rmc_tally, long_sentence_traits> rmc_only(rmc_tally {&calls}); // the proprietary ones are skipped
+    rmc_only.parse(long_stream, sizeof(long_stream) - 1);
+    BOOST_CHECK_EQUAL(calls, 2u);
+}
+
+BOOST_AUTO_TEST_CASE (test_push_decoder)
+{
+    using namespace serial;
+    std::string data;
+    std::mt19937 gen(21);
+    std::uniform_int_distribution<int> pick(0, 9);
+    for (int i = 0; i < 200; ++i)
+    {
+        switch (pick(gen))
+        {
+            case 1: data += std::string(pick(gen) * 20, 'x'); break;
+            case 2: data += "\x0D\x0A\x0D"; break;
+            default: data += (i % 2) ? mixed_sentences : mixed_stream; break;
+        }
+    }
+
+    std::vector<std::string> expected;
+    std::vector<rmc_fix> fixes_expected;
+    machine<600, sentence_log> m(sentence_log {&expected});
+    m.parse(data.data(), data.size());
+    machine<600, fix_log> typed(fix_log {&fixes_expected});
+    typed.parse(data.data(), data.size());
+    BOOST_REQUIRE(expected.size() > 500);
+
+    std::uniform_int_distribution<size_t> chunk(1, 8);
+    std::vector<std::string> lines;
+    std::vector<rmc_fix> fixes;
+    push_decoder<sentence_log, counting_traits> decoder(sentence_log {&lines});
+    push_decoder<fix_log> typed_decoder(fix_log {&fixes});
+    for (size_t offset = 0, n = 0; offset < data.size(); offset += n)
+    {
+        n = std::min(chunk(gen), data.size() - offset);
+        decoder.push(data.data() + offset, n);
+        typed_decoder.push(data.data() + offset, n);
+    }
+    BOOST_REQUIRE(lines == expected);
+    BOOST_REQUIRE_EQUAL(fixes.size(), fixes_expected.size());
+    for (size_t i = 0; i < fixes.size(); ++i)
+    {
+        BOOST_CHECK(fixes[i].time == fixes_expected[i].time);
+        BOOST_CHECK_EQUAL(fixes[i].latitude, fixes_expected[i].latitude);
+        BOOST_CHECK_EQUAL(fixes[i].speed, fixes_expected[i].speed);
+        BOOST_CHECK_EQUAL(fixes[i].variation, fixes_expected[i].variation);
+    }
+    BOOST_CHECK_EQUAL(decoder.stats().bytes_consumed, data.size());
+
+    lines.clear(); // a sentence cut short by the next one does not take it along
+    std::string const cut = std::string("$GPRMC,0818") + mixed_stream;
+    decoder.push(cut.data(), cut.size());
+    BOOST_CHECK_EQUAL(lines.size(), 4u);
+
+    size_t calls = 0;
+    push_decoder<rmc_tally, long_sentence_traits> long_decoder(rmc_tally {&calls});
+    for (size_t i = 0; i < sizeof(long_stream) - 1; ++i)
+    {
+        long_decoder.push(long_stream + i, 1);
+    }
+    BOOST_CHECK_EQUAL(calls, 2u);
+
+    // 81 and 82 characters up to the cr are taken, 83 are not; checksum digits that are not hex fail the checksum
+    auto const sentence = [](std::string const & body)
+    {
+        uint8_t sum = 0;
+        for (char c : body)
+        {
+            sum ^= uint8_t(c);
+        }
+        char digits[3];
+        std::snprintf(digits, sizeof(digits), "%02X", sum);
+        return '$' + body + '*' + digits + "\x0D\x0A";
+    };
+    std::string const limits = sentence("GPRMC,081836.000,A,3751.65111111,S,14507.36222222,E,000.0,360.0,130919,011.3,E")
+                             + sentence("GPRMC,081836.000,A,3751.651111111,S,14507.36222222,E,000.0,360.0,130919,011.3,E")
+                             + sentence("GPRMC,081836.000,A,3751.651111111,S,14507.362222222,E,000.0,360.0,130919,011.3,E")
+                             + "$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*G5\x0D\x0A";
+    size_t machine_calls = 0, push_calls = 0;
+    machine<300, rmc_tally, counting_traits> limit_machine(rmc_tally {&machine_calls});
+    limit_machine.parse(limits.data(), limits.size());
+    push_decoder<rmc_tally, counting_traits> limit_decoder(rmc_tally {&push_calls});
+    limit_decoder.push(limits.data(), limits.size());
+    BOOST_CHECK_EQUAL(machine_calls, 2u);
+    BOOST_CHECK_EQUAL(push_calls, 2u);
+    BOOST_CHECK_EQUAL(limit_machine.stats().checksum_failures, 1u);
+    BOOST_CHECK_EQUAL(limit_decoder.stats().checksum_failures, 1u);
+    BOOST_CHECK_EQUAL(limit_decoder.stats().malformed, 0u);
+}
+
+struct replay_tally
+{
+    serial::replayer * replay;
+    void operator()(serial::minmea_sentence_rmc const &) const
+    {
+        replay->delivered();
+    }
+};
+
+BOOST_AUTO_TEST_CASE (test_capture_replay)
+{
+    using namespace serial;
+    char path[] = "/tmp/capture_XXXXXX";
+    auto const fd = mkstemp(path);
+    BOOST_REQUIRE(fd >= 0);
+    close(fd);
+    size_t const chunk = 23;
+    size_t const size = sizeof(mixed_stream) - 1;
+    {
+        capture_writer out(path);
+        BOOST_REQUIRE(out.is_open());
+        for (size_t offset = 0, i = 0; offset < size; offset += chunk, ++i)
+        {
+            BOOST_REQUIRE(out.record(std::chrono::milliseconds(i), mixed_stream + offset, std::min(chunk, size - offset)));
+        }
+    }
+    BOOST_REQUIRE_EQUAL(truncate(path, 8 + (12 + chunk) * 4 + 5), 0); // as if the recording was killed in a record
+
+    capture const in(path);
+    BOOST_REQUIRE(in.is_open());
+    BOOST_REQUIRE_EQUAL(in.chunks().size(), 4u);
+    BOOST_CHECK_EQUAL(in.bytes(), 4 * chunk);
+    BOOST_CHECK(in.duration() == std::chrono::milliseconds(3));
+    BOOST_CHECK(std::memcmp(in.chunks()[2].data, mixed_stream + 2 * chunk, chunk) == 0);
+
+    capture_writer again(path);
+    for (size_t offset = 0, i = 0; offset < size; offset += chunk, ++i)
+    {
+        again.record(std::chrono::milliseconds(i), mixed_stream + offset, std::min(chunk, size - offset));
+    }
+    again.close();
+    capture const whole(path);
+    BOOST_REQUIRE_EQUAL(whole.bytes(), size);
+    unlink(path);
+
+    replayer replay(whole.chunks());
+    for (double speed : {0.0, 4.0})
+    {
+        machine<300, replay_tally> m(replay_tally {&replay});
+        auto const report = replay.run(speed, [&m](char const * data, size_t n) { m.parse(data, n); });
+        BOOST_CHECK_EQUAL(report.bytes, size);
+        BOOST_CHECK_EQUAL(report.latencies.size(), 4u);
+        BOOST_CHECK(std::is_sorted(report.latencies.begin(), report.latencies.end()));
+        BOOST_CHECK(report.percentile(1) == report.latencies.back());
+        if (speed > 0)
+        {
+            BOOST_CHECK(report.elapsed >= whole.duration() / 4);
+        }
+    }
+    BOOST_CHECK(capture("/tmp").chunks().size() == 0);
+}
+
+struct tick_clock // a tick per reading, so the order of the stamps shows
+{
+    static inline uint64_t ticks = 0;
+    static uint64_t now() noexcept
+    {
+        return ++ticks;
+    }
+};
+
+struct times_log
+{
+    static inline std::vector<serial::sentence_times> times;
+    void operator()(serial::sentence_id id, serial::sentence_times const & t) const
+    {
+        BOOST_CHECK(id == serial::sentence_id::rmc);
+        times.push_back(t);
+    }
+};
+
+struct probed_traits : serial::default_traits
+{
+    using latency_type = serial::latency_probe<tick_clock, times_log>;
+};
+
+struct histogram_traits : serial::default_traits
+{
+    using latency_type = serial::latency_probe<serial::steady_tick_clock>;
+};
+
+BOOST_AUTO_TEST_CASE (test_latency_probe)
+{
+    using namespace serial;
+    static_assert(std::is_empty_v<no_latency>);
+
+    for (bool span : {false, true})
+    {
+        times_log::times.clear();
+        machine<300, rmc_counter, probed_traits> m;
+        for (size_t offset = 0; offset < sizeof(mixed_stream) - 1; offset += 16)
+        {
+            auto const n = std::min<size_t>(16, sizeof(mixed_stream) - 1 - offset);
+            if (span)
+            {
+                m.parse(mixed_stream + offset, n);
+            } else
+            {
+                m.fill_data(mixed_stream + offset, n);
+                m.parse_all();
+            }
+        }
+        BOOST_REQUIRE_EQUAL(times_log::times.size(), 4u);
+        for (auto const & t : times_log::times)
+        {
+            BOOST_CHECK(t.dollar < t.crlf);
+            BOOST_CHECK(t.crlf < t.callback);
+        }
+    }
+
+    // a sentence over two calls has its '$' stamped by the first one
+    std::string const split = "$GPRMC,081836.000,A,3751.65,S,14507.36,E,000.0,360.0,130919,011.3,E*75\x0D\x0A";
+    for (size_t cut : {1, 4, 8, 40, 71})
+    {
+        times_log::times.clear();
+        machine<300, rmc_counter, probed_traits> m;
+        m.parse(split.data(), cut);
+        auto const between = tick_clock::now();
+        m.parse(split.data() + cut, split.size() - cut);
+        BOOST_REQUIRE_EQUAL(times_log::times.size(), 1u);
+        BOOST_CHECK(times_log::times[0].dollar < between);
+        BOOST_CHECK(between < times_log::times[0].crlf);
+    }
+
+    machine<300, rmc_counter, histogram_traits> timed;
+    timed.parse(mixed_stream, sizeof(mixed_stream) - 1);
+    auto const & histogram = timed.latency().sink;
+    BOOST_CHECK_EQUAL(std::accumulate(std::begin(histogram.from_dollar), std::end(histogram.from_dollar), uint64_t {0}), 4u);
+    BOOST_CHECK_EQUAL(std::accumulate(std::begin(histogram.from_crlf), std::end(histogram.from_crlf), uint64_t {0}), 4u);
+}
+
+BOOST_AUTO_TEST_CASE (test_oversize_sentence_keeps_what_follows)
+{
+    using namespace serial;
+    std::string const data = "$GPRMC" + std::string(63, '8') + ",234931,V,,S,4464.0926,E,776.6,561.6,905031,411.4,*19\x0D\x0A"
+                             + mixed_stream;
+    for (size_t chunk : {size_t {1}, size_t {40}, data.size()}) // its CR-LF and the sentences after it in one fill too
+    {
+        size_t calls = 0;
+        machine<1024, rmc_tally, counting_traits> m(rmc_tally {&calls});
+        for (size_t offset = 0; offset < data.size(); offset += chunk)
+        {
+            m.fill_data(data.data() + offset, std::min(chunk, data.size() - offset));
+            m.parse_all();
+        }
+        BOOST_CHECK_EQUAL(calls, 4u);
+        BOOST_CHECK_EQUAL(m.stats().resyncs, 2u); // the broken line of mixed_stream runs too long as well
+    }
+}
+
+constexpr uint16_t fleet_fields = serial::rmc_field::time | serial::rmc_field::validity | serial::rmc_field::latitude |
+                                  serial::rmc_field::longitude | serial::rmc_field::speed;
+using fleet_fix = serial::rmc_subset<fleet_fields>;
+
+struct fleet_traits : serial::default_traits
+{
+    static constexpr uint16_t rmc_fields = fleet_fields;
+};
+
+struct fleet_log
+{
+    std::vector<fleet_fix> * fixes;
+    void operator()(fleet_fix const & fix) const
+    {
+        fixes->push_back(fix);
+    }
+};
+
+BOOST_AUTO_TEST_CASE (test_rmc_subset)
+{
+    using namespace serial;
+    static_assert(sizeof(fleet_fix) < sizeof(minmea_sentence_rmc));
+    static_assert(std::is_empty_v<rmc_subset<0>>);
+
+    std::vector<minmea_sentence_rmc> frames;
+    std::vector<rmc_fix> converted;
+    machine<300, both_forms> whole(both_forms {&frames, &converted});
+    whole.parse(mixed_stream, sizeof(mixed_stream) - 1);
+
+    for (bool span : {false, true})
+    {
+        std::vector<fleet_fix> fixes;
+        machine<1024, fleet_log, fleet_traits> m(fleet_log {&fixes});
+        if (span)
+        {
+            m.parse(mixed_stream, sizeof(mixed_stream) - 1);
+        } else
+        {
+            m.fill_data(mixed_stream, sizeof(mixed_stream) - 1);
+            m.parse_all();
+        }
+        BOOST_REQUIRE_EQUAL(fixes.size(), frames.size());
+        for (size_t i = 0; i < fixes.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(fixes[i].time.seconds, frames[i].time.seconds);
+            BOOST_CHECK_EQUAL(fixes[i].time.microseconds, frames[i].time.microseconds);
+            BOOST_CHECK_EQUAL(fixes[i].valid, frames[i].valid);
+            BOOST_CHECK_EQUAL(fixes[i].latitude.value, frames[i].latitude.value);
+            BOOST_CHECK_EQUAL(fixes[i].longitude.value, frames[i].longitude.value);
+            BOOST_CHECK_EQUAL(fixes[i].speed.value, frames[i].speed.value);
+        }
+    }
+
+    // the front ends without traits decode the subset as a frame type of its own, and reject callbacks taking it
+    fleet_fix batch[10] {};
+    auto const result = parse_batch(mixed_stream, sizeof(mixed_stream) - 1, span<fleet_fix>(batch));
+    BOOST_REQUIRE_EQUAL(result.decoded, frames.size());
+    size_t walked = 0;
+    for (auto const & fix : frame_range<fleet_fix>(mixed_stream, mixed_stream + sizeof(mixed_stream) - 1))
+    {
+        BOOST_REQUIRE(walked < frames.size());
+        BOOST_CHECK_EQUAL(fix.latitude.value, frames[walked].latitude.value);
+        BOOST_CHECK_EQUAL(batch[walked].longitude.value, frames[walked].longitude.value);
+        ++walked;
+    }
+    BOOST_CHECK_EQUAL(walked, frames.size());
+    static_assert(takes_some_rmc_subset<fleet_log>);
+    static_assert(!takes_some_rmc_subset<both_forms>);
+    auto const generic = [](auto const &) {};
+    static_assert(!takes_some_rmc_subset<decltype(generic)>);
+
+    char const bad_course[] = "$GPRMC,081836,A,3751.65,S,14507.36,E,000.5,3x0.0,130919,011.3,E*";
+    fleet_fix fix {};
+    minmea_sentence_rmc rmc {};
+    BOOST_CHECK(minmea_parse(&fix, bad_course + 7, bad_course + sizeof(bad_course) - 1)); // not looked at
+    BOOST_CHECK(!minmea_parse(&rmc, bad_course + 7, bad_course + sizeof(bad_course) - 1));
+    BOOST_CHECK_EQUAL(fix.speed.value, 5);
+}
+
+struct fleet_and_full_log // takes the subset and the whole frame both
+{
+    std::vector<fleet_fix> * fixes;
+    std::vector<serial::minmea_sentence_rmc> * frames;
+    void operator()(fleet_fix const & fix) const
+    {
+        fixes->push_back(fix);
+    }
+    void operator()(serial::minmea_sentence_rmc const & frame) const
+    {
+        frames->push_back(frame);
+    }
+};
+
+struct fleet_probed_traits : fleet_traits
+{
+    using stats_type = serial::parser_stats;
+    using latency_type = serial::latency_probe<tick_clock, times_log>;
+};
+
+BOOST_AUTO_TEST_CASE (test_rmc_subset_and_frame)
+{
+    using namespace serial;
+    // the course does not decode, which the subset does not look at
+    std::string const data = std::string(mixed_stream) +
+                             "$GPRMC,081836,A,3751.65,S,14507.36,E,000.5,3x0.0,130919,011.3,E*20\x0D\x0A";
+    for (bool span : {false, true})
+    {
+        times_log::times.clear();
+        std::vector<fleet_fix> fixes;
+        std::vector<minmea_sentence_rmc> frames;
+        machine<1024, fleet_and_full_log, fleet_probed_traits> m(fleet_and_full_log {&fixes, &frames});
+        if (span)
+        {
+            m.parse(data.data(), data.size());
+        } else
+        {
+            m.fill_data(data.data(), data.size());
+            m.parse_all();
+        }
+        BOOST_CHECK_EQUAL(fixes.size(), 5u);
+        BOOST_CHECK_EQUAL(frames.size(), 4u);
+        BOOST_CHECK_EQUAL(times_log::times.size(), 5u); // once a sentence
+        BOOST_CHECK_EQUAL(m.stats().field_errors, 1u);
+    }
+}